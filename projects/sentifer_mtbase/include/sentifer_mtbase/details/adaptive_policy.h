@@ -0,0 +1,14 @@
+#pragma once
+
+#include "clocks.hpp"
+#include "scheduler_restriction.h"
+
+namespace mtbase
+{
+    struct adaptive_policy final
+    {
+        const steady_tick TARGET_LATENCY_TICK;
+        const scheduler_restriction MIN_RESTRICTION;
+        const scheduler_restriction MAX_RESTRICTION;
+    };
+}
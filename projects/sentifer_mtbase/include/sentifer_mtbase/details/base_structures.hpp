@@ -35,64 +35,9 @@ namespace mtbase
             const size_t back = 1;
         };
 
-        struct alignas(BASE_ALIGN * 8) descriptor
-        {
-            enum class PHASE :
-                size_t
-            {
-                RESERVE,
-                COMPLETE,
-                FAIL
-            };
-
-        public:
-            auto operator<=> (const descriptor&) const = default;
-
-        public:
-            [[nodiscard]]
-            descriptor copied(
-                const index_t& oldIndexLoad,
-                const index_t& newIndexLoad,
-                task_t* const oldTaskLoad)
-                const noexcept;
-            [[nodiscard]]
-            descriptor rollbacked(
-                const index_t& oldIndexLoad,
-                const index_t& newIndexLoad,
-                task_t* const oldTaskLoad)
-                const noexcept;
-            [[nodiscard]]
-            descriptor completed()
-                const noexcept;
-            [[nodiscard]]
-            descriptor failed()
-                const noexcept;
-
-        public:
-            const PHASE phase{ PHASE::RESERVE };
-            const OP op{ OP::PUSH_FRONT };
-            task_t* const oldTask{ nullptr };
-            task_t* const newTask{ nullptr };
-            const index_t oldIndex{ index_t{} };
-            const index_t newIndex{ index_t{} };
-        };
-
     public:
-        task_storage(std::pmr::memory_resource* res) :
-            alloc{ res }
-        {
-            index_t idx{ index_t{} };
-            index_t* init = new_index(idx);
-            index.store(init, std::memory_order_relaxed);
-        }
-
-        virtual ~task_storage()
-        {
-            delete_index(index.load(std::memory_order_relaxed));
-
-            if (registered != nullptr)
-                delete_desc(registered.load(std::memory_order_relaxed));
-        }
+        task_storage(std::pmr::memory_resource* res);
+        virtual ~task_storage();
 
     public:
         [[nodiscard]]
@@ -103,20 +48,11 @@ namespace mtbase
         task_t* pop_front();
         [[nodiscard]]
         task_t* pop_back();
-
-    protected:
-        [[nodiscard]]
-        descriptor* createDesc(task_t* const task, OP op);
-        void destroyDesc(descriptor* const desc);
-        [[nodiscard]]
-        index_t* new_index(const index_t& idx);
-        void delete_index(index_t* const idx);
-        [[nodiscard]]
-        descriptor* new_desc(const descriptor& desc);
         [[nodiscard]]
-        descriptor* copy_desc(descriptor* const desc);
-        void delete_desc(descriptor* const desc);
+        size_t size()
+            const noexcept;
 
+    protected:
         [[nodiscard]]
         virtual std::atomic<task_t*>& getElementRef(
             const index_t& idx,
@@ -130,50 +66,126 @@ namespace mtbase
             const noexcept = 0;
 
     private:
-        void applyDesc(descriptor*& desc);
-        bool fast_path(descriptor*& desc);
-        void slow_path(descriptor*& desc);
-        void helpRegistered(descriptor*& desc);
-        [[nodiscard]]
-        bool tryCommit(descriptor*& desc);
+        struct hazard_record;
+        struct request;
+
+        // One push or pop in flight. It is published by swapping its marker
+        // into the target slot and committed by swapping it into `index`;
+        // the committed descriptor's newIndex stays the current index until
+        // the next commit replaces it. Any thread that meets the marker can
+        // finish the operation, so none of them waits on another.
+        struct alignas(BASE_ALIGN * 8) descriptor
+        {
+            // A request's attempt moves to CLAIMED once the request accepts
+            // it, after which only a moved index can fail it.
+            enum class PHASE :
+                size_t
+            {
+                RESERVE,
+                CLAIMED,
+                COMPLETE,
+                FAIL
+            };
+
+        public:
+            std::atomic<PHASE> phase{ PHASE::RESERVE };
+            const OP op{ OP::NONE };
+            task_t* const oldTask{ nullptr };
+            task_t* const newTask{ nullptr };
+            descriptor* const base{ nullptr };
+            request* const owner{ nullptr };
+            const index_t oldIndex{ index_t{} };
+            const index_t newIndex{ index_t{} };
+            // The slot marker and the index (or the failure) each hold one;
+            // a registered request holds one more for its current attempt.
+            std::atomic_size_t cntRef{ 2 };
+            descriptor* retiredNext{ nullptr };
+        };
+
+        // An operation that kept losing on the fast path. Once registered,
+        // every other operation helps it to completion before its own.
+        struct request
+        {
+            const OP op{ OP::NONE };
+            task_t* const task{ nullptr };
+            std::atomic<descriptor*> attempt{ nullptr };
+            std::atomic_size_t cntRef{ 1 };
+            request* retiredNext{ nullptr };
+        };
+
+        enum class RESULT :
+            size_t
+        {
+            COMPLETE,
+            INVALID,
+            RETRY
+        };
+
+    private:
         [[nodiscard]]
-        bool tryCommitWithRegistered(descriptor*& desc);
+        bool applyDesc(const OP op, task_t* const task, task_t*& popped);
         [[nodiscard]]
-        descriptor* rollbackTask(descriptor*& desc);
+        RESULT fast_path(
+            hazard_record& hp,
+            const OP op,
+            task_t* const task,
+            request* const owner,
+            task_t*& popped);
         [[nodiscard]]
-        descriptor* refreshIndex(descriptor*& desc);
-        void completeDesc(descriptor*& desc);
-        void renewRegistered(
-            descriptor* const oldDesc,
-            descriptor*& desc);
-
+        RESULT slow_path(
+            hazard_record& hp,
+            const OP op,
+            task_t* const task,
+            task_t*& popped);
+        void helpRegistered(hazard_record& hp);
+        void helpRequest(hazard_record& hp, request* const req);
+        void helpMarker(
+            hazard_record& hp,
+            std::atomic<task_t*>& target,
+            task_t* const marker);
+        void helpDesc(hazard_record& hp, descriptor* const desc);
+        void tryCommitIndex(hazard_record& hp, descriptor* const desc);
         [[nodiscard]]
-        bool trySetProgress(const OP op)
+        bool tryClaim(
+            hazard_record& hp,
+            request* const req,
+            descriptor* const desc);
+        void completeDesc(descriptor* const desc)
             noexcept;
-        void releaseProgress(const OP op)
+        void tryFailDesc(descriptor* const desc);
+        void tryFailUnclaimedDesc(descriptor* const desc);
+        void finalizeDesc(descriptor* const desc);
+        void unregister(request* const req);
+
+        void releaseDesc(descriptor* const desc);
+        void releaseRequest(request* const req);
+        void deleteDesc(descriptor* const desc);
+        void retireDesc(descriptor* const desc)
             noexcept;
-        [[nodiscard]]
-        std::atomic_bool& getTargetProgress(const OP op)
+        void retireRequest(request* const req)
             noexcept;
+        void reclaim();
+        void reclaimAll();
+
         [[nodiscard]]
-        bool tryCommitTask(descriptor* const desc)
-            noexcept;
+        static hazard_record& localHazardRecord();
         [[nodiscard]]
-        bool tryCommitIndex(descriptor* const desc)
+        static std::atomic<hazard_record*>& hazardRecords()
             noexcept;
-        bool tryRegister(
-            descriptor*& expected,
-            descriptor* const desired)
+        [[nodiscard]]
+        static descriptor* finishedAttempt()
             noexcept;
 
     private:
         static constexpr size_t MAX_RETRY = 4;
+        static constexpr size_t RECLAIM_BATCH = 64;
 
         std::atomic_size_t cnt = 0;
-        std::atomic<index_t*> index;
-        std::atomic<descriptor*> registered{ nullptr };
-        std::atomic_bool progressFront{ false };
-        std::atomic_bool progressBack{ false };
+        std::atomic<descriptor*> index;
+        std::atomic<request*> registered{ nullptr };
+        std::atomic<descriptor*> retiredDescs{ nullptr };
+        std::atomic<request*> retiredRequests{ nullptr };
+        std::atomic_size_t cntRetired{ 0 };
         generic_allocator alloc;
     };
 
@@ -0,0 +1,258 @@
+#pragma once
+
+#include <atomic>
+#include <bit>
+#include <memory_resource>
+#include <optional>
+#include <span>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "tasks.hpp"
+#include "schedulers/object_scheduler.h"
+
+namespace mtbase
+{
+    template<class Handler, class... Args>
+    struct batch_handler final
+    {
+        static_assert(sizeof...(Args) > 0);
+        static_assert(std::is_invocable_v<Handler&, std::span<Args>...>);
+
+    private:
+        using row_type = std::tuple<Args...>;
+        using columns_type = std::tuple<std::pmr::vector<Args>...>;
+
+        struct batch_slot
+        {
+            std::atomic_size_t sequence{ 0 };
+            std::optional<row_type> row;
+        };
+
+        struct task_batch_t :
+            public task_invoke_t
+        {
+            task_batch_t(batch_handler& handler) :
+                task_invoke_t{},
+                owner{ handler }
+            {}
+
+        public:
+            void invoke() override
+            {
+                owner.drain();
+            }
+
+            [[nodiscard]]
+            bool tryReleaseIntrusive()
+                noexcept override
+            {
+                return true;
+            }
+
+        private:
+            batch_handler& owner;
+        };
+
+    public:
+        batch_handler(
+            std::pmr::memory_resource* res,
+            object_scheduler* const targetSched,
+            const size_t capacity,
+            Handler&& handler) :
+            sched{ targetSched },
+            handled{ std::move(handler) },
+            slots{ std::bit_ceil(capacity), res },
+            MASK{ slots.size() - 1 },
+            columns{ std::pmr::vector<Args>{ res }... },
+            batchTask{ *this }
+        {
+            for (size_t i = 0; i < slots.size(); ++i)
+                slots[i].sequence.store(i, std::memory_order_relaxed);
+
+            std::apply([this](std::pmr::vector<Args>&... column)
+                {
+                    (column.reserve(slots.size()), ...);
+                }, columns);
+        }
+
+        batch_handler(const batch_handler&) = delete;
+        batch_handler& operator=(const batch_handler&) = delete;
+
+    public:
+        template<class... Ts>
+        [[nodiscard]]
+        bool post(Ts&&... args)
+        {
+            static_assert(sizeof...(Ts) == sizeof...(Args));
+
+            size_t pos = tail.load(std::memory_order_relaxed);
+            batch_slot* slot = nullptr;
+
+            while (true)
+            {
+                slot = &slots[pos & MASK];
+
+                const size_t sequence = slot->sequence.load(std::memory_order_acquire);
+                const std::ptrdiff_t diff =
+                    static_cast<std::ptrdiff_t>(sequence - pos);
+                if (diff == 0)
+                {
+                    if (tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                        break;
+                }
+                else if (diff < 0)
+                    return false;
+                else
+                    pos = tail.load(std::memory_order_relaxed);
+            }
+
+            try
+            {
+                slot->row.emplace(std::forward<Ts>(args)...);
+            }
+            catch (...)
+            {
+                slot->sequence.store(pos + 1, std::memory_order_seq_cst);
+                activate();
+
+                throw;
+            }
+
+            slot->sequence.store(pos + 1, std::memory_order_seq_cst);
+            activate();
+
+            return true;
+        }
+
+        [[nodiscard]]
+        size_t getCapacity()
+            const noexcept
+        {
+            return slots.size();
+        }
+
+    private:
+        void activate()
+        {
+            if (!isDrainScheduled.exchange(true, std::memory_order_seq_cst))
+                sched->registerBatchTask(&batchTask);
+        }
+
+        void drain()
+        {
+            try
+            {
+                for (size_t i = 0; i < slots.size() && tryTakeOne(); ++i);
+
+                if (!std::get<0>(columns).empty())
+                    std::apply([this](std::pmr::vector<Args>&... column)
+                        {
+                            handled(std::span<Args>{ column }...);
+                        }, columns);
+            }
+            catch (...)
+            {
+                clearColumns();
+                rearm();
+
+                throw;
+            }
+
+            clearColumns();
+            rearm();
+        }
+
+        [[nodiscard]]
+        bool tryTakeOne()
+        {
+            batch_slot& slot = slots[head & MASK];
+            if (slot.sequence.load(std::memory_order_acquire) != head + 1)
+                return false;
+
+            try
+            {
+                if (slot.row.has_value())
+                    appendRow(*slot.row, std::index_sequence_for<Args...>{});
+            }
+            catch (...)
+            {
+                releaseSlot(slot);
+
+                throw;
+            }
+
+            releaseSlot(slot);
+
+            return true;
+        }
+
+        template<size_t... I>
+        void appendRow(row_type& row, std::index_sequence<I...>)
+        {
+            size_t cntAppended = 0;
+
+            try
+            {
+                ((std::get<I>(columns).emplace_back(std::move(std::get<I>(row))),
+                    ++cntAppended), ...);
+            }
+            catch (...)
+            {
+                ((I < cntAppended ? std::get<I>(columns).pop_back() : void()), ...);
+
+                throw;
+            }
+        }
+
+        void releaseSlot(batch_slot& slot)
+            noexcept
+        {
+            slot.row.reset();
+            slot.sequence.store(head + slots.size(), std::memory_order_release);
+            ++head;
+        }
+
+        void clearColumns()
+            noexcept
+        {
+            std::apply([](std::pmr::vector<Args>&... column)
+                {
+                    (column.clear(), ...);
+                }, columns);
+        }
+
+        void rearm()
+        {
+            isDrainScheduled.store(false, std::memory_order_seq_cst);
+
+            if (slots[head & MASK].sequence.load(std::memory_order_seq_cst) == head + 1)
+                activate();
+        }
+
+    private:
+        object_scheduler* const sched;
+        Handler handled;
+        std::pmr::vector<batch_slot> slots;
+        const size_t MASK;
+        columns_type columns;
+        task_batch_t batchTask;
+        std::atomic_size_t tail{ 0 };
+        size_t head{ 0 };
+        std::atomic_bool isDrainScheduled{ false };
+    };
+
+    template<class... Args, class Handler>
+    [[nodiscard]]
+    batch_handler<std::decay_t<Handler>, Args...> make_batch_handler(
+        std::pmr::memory_resource* res,
+        object_scheduler* const targetSched,
+        const size_t capacity,
+        Handler&& handler)
+    {
+        return batch_handler<std::decay_t<Handler>, Args...>{
+            res, targetSched, capacity, std::decay_t<Handler>{ std::forward<Handler>(handler) } };
+    }
+}
@@ -10,6 +10,11 @@ namespace mtbase
 
     struct control_block
     {
+        control_block(thread_local_scheduler& ownerSched) :
+            owner{ ownerSched }
+        {}
+
+    public:
         void reset()
             noexcept;
         void release()
@@ -0,0 +1,280 @@
+#pragma once
+
+#include <coroutine>
+#include <exception>
+#include <optional>
+#include <utility>
+
+#include "clocks.hpp"
+#include "mtbase_assert.h"
+#include "tasks.hpp"
+#include "schedulers/object_scheduler.h"
+
+namespace mtbase
+{
+    struct schedule_awaiter
+    {
+        schedule_awaiter(object_scheduler& sched) noexcept :
+            objectSched{ sched }
+        {}
+
+    public:
+        [[nodiscard]]
+        bool await_ready()
+            const noexcept
+        {
+            return false;
+        }
+
+        void await_suspend(std::coroutine_handle<> handle)
+        {
+            resumeTask.handle = handle;
+            objectSched.registerResumeTask(&resumeTask);
+        }
+
+        void await_resume()
+            const noexcept
+        {}
+
+    private:
+        object_scheduler& objectSched;
+        task_resume_t resumeTask;
+    };
+
+    struct after_awaiter
+    {
+        after_awaiter(
+            object_scheduler& sched,
+            const steady_tick after) noexcept :
+            objectSched{ sched },
+            tickAfter{ after }
+        {}
+
+    public:
+        [[nodiscard]]
+        bool await_ready()
+            const noexcept
+        {
+            return false;
+        }
+
+        void await_suspend(std::coroutine_handle<> handle)
+        {
+            resumeTask.handle = handle;
+            objectSched.registerResumeTaskAt(
+                clock_t::getSteadyTick() + tickAfter, &resumeTask, timer);
+        }
+
+        void await_resume()
+            const noexcept
+        {}
+
+    private:
+        object_scheduler& objectSched;
+        const steady_tick tickAfter;
+        task_resume_t resumeTask;
+        timer_handle timer;
+    };
+
+    namespace details
+    {
+        struct task_promise_base
+        {
+            struct final_awaiter
+            {
+                [[nodiscard]]
+                bool await_ready()
+                    const noexcept
+                {
+                    return false;
+                }
+
+                template<class Promise>
+                std::coroutine_handle<> await_suspend(
+                    std::coroutine_handle<Promise> handle)
+                    noexcept
+                {
+                    task_promise_base& promise = handle.promise();
+                    if (promise.continuation)
+                        return promise.continuation;
+
+                    if (promise.isDetached)
+                        handle.destroy();
+
+                    return std::noop_coroutine();
+                }
+
+                void await_resume()
+                    const noexcept
+                {}
+            };
+
+        public:
+            std::suspend_always initial_suspend()
+                const noexcept
+            {
+                return {};
+            }
+
+            final_awaiter final_suspend()
+                const noexcept
+            {
+                return {};
+            }
+
+            void unhandled_exception()
+                noexcept
+            {
+                if (isDetached)
+                    std::terminate();
+
+                exception = std::current_exception();
+            }
+
+            void rethrowIfFailed()
+                const
+            {
+                if (exception)
+                    std::rethrow_exception(exception);
+            }
+
+        public:
+            std::coroutine_handle<> continuation{ nullptr };
+            std::exception_ptr exception{ nullptr };
+            bool isDetached{ false };
+        };
+
+        template<class T>
+        struct task_promise :
+            public task_promise_base
+        {
+            template<class U>
+            void return_value(U&& value)
+            {
+                result.emplace(std::forward<U>(value));
+            }
+
+            T takeResult()
+            {
+                rethrowIfFailed();
+
+                return std::move(*result);
+            }
+
+        private:
+            std::optional<T> result;
+        };
+
+        template<>
+        struct task_promise<void> :
+            public task_promise_base
+        {
+            void return_void()
+                const noexcept
+            {}
+
+            void takeResult()
+                const
+            {
+                rethrowIfFailed();
+            }
+        };
+    }
+
+    template<class T = void>
+    struct task
+    {
+        struct promise_type :
+            public details::task_promise<T>
+        {
+            task get_return_object()
+                noexcept
+            {
+                return task{ std::coroutine_handle<promise_type>::from_promise(*this) };
+            }
+        };
+
+        struct awaiter
+        {
+            [[nodiscard]]
+            bool await_ready()
+                const noexcept
+            {
+                return handle.done();
+            }
+
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<> continuation)
+                noexcept
+            {
+                handle.promise().continuation = continuation;
+
+                return handle;
+            }
+
+            T await_resume()
+            {
+                return handle.promise().takeResult();
+            }
+
+        public:
+            std::coroutine_handle<promise_type> handle;
+        };
+
+    public:
+        task() noexcept = default;
+        task(const task&) = delete;
+        task(task&& other) noexcept :
+            handle{ std::exchange(other.handle, nullptr) }
+        {}
+
+        ~task()
+        {
+            if (handle)
+                handle.destroy();
+        }
+
+        task& operator=(const task&) = delete;
+        task& operator=(task&& other) noexcept
+        {
+            if (this != &other)
+            {
+                if (handle)
+                    handle.destroy();
+
+                handle = std::exchange(other.handle, nullptr);
+            }
+
+            return *this;
+        }
+
+    public:
+        // Awaiting or detaching an empty or moved-from task is a bug; there
+        // is no coroutine to run and no result to hand back.
+        awaiter operator co_await() &&
+            noexcept
+        {
+            MTBASE_ASSERT(handle != nullptr);
+
+            return awaiter{ handle };
+        }
+
+        void detach() &&
+        {
+            MTBASE_ASSERT(handle != nullptr);
+
+            std::coroutine_handle<promise_type> detached =
+                std::exchange(handle, nullptr);
+
+            detached.promise().isDetached = true;
+            detached.resume();
+        }
+
+    private:
+        explicit task(std::coroutine_handle<promise_type> h) noexcept :
+            handle{ h }
+        {}
+
+    private:
+        std::coroutine_handle<promise_type> handle{ nullptr };
+    };
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+
+#include "clocks.hpp"
+
+namespace mtbase
+{
+    struct idle_statistics final
+    {
+        size_t cntParked{ 0 };
+        size_t cntWokenUp{ 0 };
+        steady_tick tickWakeUpLatencyTotal{ steady_tick{} };
+        steady_tick tickWakeUpLatencyMax{ steady_tick{} };
+    };
+
+    struct event_count
+    {
+        [[nodiscard]]
+        size_t prepareWait()
+            noexcept;
+        void cancelWait()
+            noexcept;
+        void wait(
+            const size_t key,
+            const steady_tick tickParkUntil);
+        void notifyOne();
+        void notifyAll();
+
+        [[nodiscard]]
+        idle_statistics getStatistics()
+            const noexcept;
+
+    private:
+        void recordWakeUp(const steady_tick tickWokenUp)
+            noexcept;
+
+    private:
+        std::atomic_size_t epoch{ 0 };
+        std::atomic_size_t cntWaiters{ 0 };
+        std::atomic<steady_tick::rep> tickNotified{ 0 };
+        std::mutex mtx;
+        std::condition_variable cv;
+
+        std::atomic_size_t cntParked{ 0 };
+        std::atomic_size_t cntWokenUp{ 0 };
+        std::atomic<steady_tick::rep> tickLatencyTotal{ 0 };
+        std::atomic<steady_tick::rep> tickLatencyMax{ 0 };
+    };
+}
@@ -0,0 +1,575 @@
+#pragma once
+
+#include <atomic>
+#include <exception>
+#include <functional>
+#include <limits>
+#include <memory_resource>
+#include <optional>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "memory_managers.hpp"
+#include "mtbase_assert.h"
+#include "tasks.hpp"
+
+namespace mtbase
+{
+    struct object_scheduler;
+
+    template<class T>
+    struct future;
+
+    namespace details
+    {
+        struct future_listener
+        {
+            virtual ~future_listener()
+            {}
+
+        public:
+            virtual void notifyReady() = 0;
+        };
+
+        struct ready_listener final :
+            public future_listener
+        {
+            void notifyReady() override
+            {}
+        };
+
+        inline ready_listener READY_LISTENER;
+
+        template<class T>
+        struct future_result
+        {
+            template<class U>
+            void set(U&& result)
+            {
+                value.emplace(std::forward<U>(result));
+            }
+
+            T take()
+            {
+                return std::move(*value);
+            }
+
+        private:
+            std::optional<T> value;
+        };
+
+        template<>
+        struct future_result<void>
+        {
+            void take()
+                const noexcept
+            {}
+        };
+
+        template<class Source, class Func>
+        struct then_result
+        {
+            using type = std::invoke_result_t<Func&, Source>;
+        };
+
+        template<class Func>
+        struct then_result<void, Func>
+        {
+            using type = std::invoke_result_t<Func&>;
+        };
+
+        struct future_dispatcher
+        {
+            future_dispatcher(object_scheduler* const sched) noexcept :
+                targetSched{ sched }
+            {}
+
+        public:
+            void dispatch(task_invoke_t* const task)
+                const;
+
+        private:
+            object_scheduler* const targetSched;
+        };
+    }
+
+    template<class T>
+    struct future_state
+    {
+        future_state(
+            std::pmr::memory_resource* const res,
+            const size_t cntInitialRef) noexcept :
+            resource{ res },
+            cntRef{ cntInitialRef }
+        {}
+
+        virtual ~future_state()
+        {}
+
+    public:
+        [[nodiscard]]
+        bool isReady()
+            const noexcept
+        {
+            return listener.load(std::memory_order_acquire) == &details::READY_LISTENER;
+        }
+
+        [[nodiscard]]
+        bool tryListen(details::future_listener* const newListener)
+            noexcept
+        {
+            details::future_listener* oldListener = nullptr;
+            return listener.compare_exchange_strong(oldListener, newListener,
+                std::memory_order_acq_rel, std::memory_order_acquire);
+        }
+
+        T takeResult()
+        {
+            if (exception)
+                std::rethrow_exception(exception);
+
+            return result.take();
+        }
+
+        void acquire()
+            noexcept
+        {
+            cntRef.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        void release()
+            noexcept
+        {
+            if (cntRef.fetch_sub(1, std::memory_order_acq_rel) == 1)
+                destroy();
+        }
+
+        [[nodiscard]]
+        std::pmr::memory_resource* getResource()
+            const noexcept
+        {
+            return resource;
+        }
+
+    protected:
+        template<class Produce>
+        void complete(Produce&& produce)
+        {
+            try
+            {
+                if constexpr (std::is_void_v<T>)
+                    produce();
+                else
+                    result.set(produce());
+            }
+            catch (...)
+            {
+                exception = std::current_exception();
+            }
+
+            details::future_listener* const oldListener = listener.exchange(
+                &details::READY_LISTENER, std::memory_order_acq_rel);
+            if (oldListener != nullptr)
+                oldListener->notifyReady();
+        }
+
+        virtual void destroy()
+            noexcept = 0;
+
+    protected:
+        std::pmr::memory_resource* const resource;
+
+    private:
+        details::future_result<T> result;
+        std::exception_ptr exception{ nullptr };
+        std::atomic<details::future_listener*> listener{ nullptr };
+        std::atomic_size_t cntRef;
+    };
+
+    template<class Func, class TupleArgs>
+    struct task_future_func_t :
+        public task_invoke_t,
+        public future_state<decltype(std::apply(
+            std::declval<Func&>(), std::declval<TupleArgs&>()))>
+    {
+        using result_type = decltype(std::apply(
+            std::declval<Func&>(), std::declval<TupleArgs&>()));
+
+        template<class F, class Tuple>
+        task_future_func_t(
+            std::pmr::memory_resource* const res,
+            F&& func,
+            Tuple&& args) :
+            task_invoke_t{},
+            future_state<result_type>{ res, 2 },
+            invoked{ std::forward<F>(func) },
+            tupled{ std::forward<Tuple>(args) }
+        {}
+
+        virtual ~task_future_func_t()
+        {}
+
+    public:
+        void invoke() override
+        {
+            this->complete([this]() -> result_type
+                {
+                    return std::apply(invoked, tupled);
+                });
+        }
+
+        [[nodiscard]]
+        bool tryReleaseIntrusive()
+            noexcept override
+        {
+            this->release();
+
+            return true;
+        }
+
+    protected:
+        void destroy()
+            noexcept override
+        {
+            generic_allocator{ this->resource }.delete_object(this);
+        }
+
+    private:
+        Func invoked;
+        TupleArgs tupled;
+    };
+
+    template<class Source, class Func>
+    using then_result_t = typename details::then_result<Source, Func>::type;
+
+    template<class Source, class Func>
+    struct task_future_then_t :
+        public task_invoke_t,
+        public future_state<then_result_t<Source, Func>>,
+        public details::future_listener
+    {
+        using result_type = then_result_t<Source, Func>;
+
+        template<class F>
+        task_future_then_t(
+            std::pmr::memory_resource* const res,
+            object_scheduler* const targetSched,
+            future<Source>&& sourceFuture,
+            F&& func) :
+            task_invoke_t{},
+            future_state<result_type>{ res, 2 },
+            dispatcher{ targetSched },
+            source{ std::move(sourceFuture) },
+            invoked{ std::forward<F>(func) }
+        {}
+
+        virtual ~task_future_then_t()
+        {}
+
+    public:
+        void invoke() override
+        {
+            this->complete([this]() -> result_type
+                {
+                    if constexpr (std::is_void_v<Source>)
+                    {
+                        source.get();
+
+                        return std::invoke(invoked);
+                    }
+                    else
+                        return std::invoke(invoked, source.get());
+                });
+        }
+
+        [[nodiscard]]
+        bool tryReleaseIntrusive()
+            noexcept override
+        {
+            this->release();
+
+            return true;
+        }
+
+        void notifyReady() override
+        {
+            dispatcher.dispatch(this);
+        }
+
+        void listen()
+        {
+            if (!source.tryListen(this))
+                notifyReady();
+        }
+
+    protected:
+        void destroy()
+            noexcept override
+        {
+            generic_allocator{ this->resource }.delete_object(this);
+        }
+
+    private:
+        const details::future_dispatcher dispatcher;
+        future<Source> source;
+        Func invoked;
+    };
+
+    template<class T>
+    struct future
+    {
+        future() noexcept = default;
+        explicit future(future_state<T>* const adopted) noexcept :
+            state{ adopted }
+        {}
+
+        future(const future&) = delete;
+        future(future&& other) noexcept :
+            state{ std::exchange(other.state, nullptr) }
+        {}
+
+        ~future()
+        {
+            reset();
+        }
+
+        future& operator=(const future&) = delete;
+        future& operator=(future&& other) noexcept
+        {
+            if (this != &other)
+            {
+                reset();
+
+                state = std::exchange(other.state, nullptr);
+            }
+
+            return *this;
+        }
+
+    public:
+        [[nodiscard]]
+        bool isValid()
+            const noexcept
+        {
+            return state != nullptr;
+        }
+
+        [[nodiscard]]
+        bool isReady()
+            const noexcept
+        {
+            return state != nullptr && state->isReady();
+        }
+
+        T get()
+        {
+            MTBASE_ASSERT(isReady());
+
+            return state->takeResult();
+        }
+
+        template<class Schedulable, class Func>
+        auto then(Schedulable& target, Func&& func) &&
+        {
+            using task_type = task_future_then_t<T, std::decay_t<Func>>;
+            using result_type = typename task_type::result_type;
+
+            std::pmr::memory_resource* const res = state->getResource();
+            task_type* const task = generic_allocator{ res }.new_object<task_type>(
+                res, target.getScheduler(), std::move(*this), std::forward<Func>(func));
+            future<result_type> result{ task };
+
+            task->listen();
+
+            return result;
+        }
+
+        [[nodiscard]]
+        bool tryListen(details::future_listener* const listener)
+            noexcept
+        {
+            return state->tryListen(listener);
+        }
+
+    private:
+        void reset()
+            noexcept
+        {
+            if (state != nullptr)
+                state->release();
+
+            state = nullptr;
+        }
+
+    private:
+        future_state<T>* state{ nullptr };
+    };
+
+    template<class T>
+    struct when_any_result
+    {
+        size_t index{ std::numeric_limits<size_t>::max() };
+        std::pmr::vector<future<T>> futures;
+    };
+
+    template<class T>
+    struct future_when_all_t :
+        public future_state<std::pmr::vector<future<T>>>,
+        public details::future_listener
+    {
+        future_when_all_t(
+            std::pmr::memory_resource* const res,
+            std::pmr::vector<future<T>>&& inputs) :
+            future_state<std::pmr::vector<future<T>>>{ res, 1 + inputs.size() },
+            futures{ std::move(inputs) },
+            cntPending{ futures.size() + 1 }
+        {}
+
+        virtual ~future_when_all_t()
+        {}
+
+    public:
+        void notifyReady() override
+        {
+            arrive();
+            this->release();
+        }
+
+        void listen()
+        {
+            for (future<T>& input : futures)
+            {
+                if (!input.tryListen(this))
+                    notifyReady();
+            }
+
+            arrive();
+        }
+
+    protected:
+        void destroy()
+            noexcept override
+        {
+            generic_allocator{ this->resource }.delete_object(this);
+        }
+
+    private:
+        void arrive()
+        {
+            if (cntPending.fetch_sub(1, std::memory_order_acq_rel) != 1)
+                return;
+
+            this->complete([this]
+                {
+                    return std::move(futures);
+                });
+        }
+
+    private:
+        std::pmr::vector<future<T>> futures;
+        std::atomic_size_t cntPending;
+    };
+
+    template<class T>
+    struct future_when_any_t :
+        public future_state<when_any_result<T>>,
+        public details::future_listener
+    {
+        future_when_any_t(
+            std::pmr::memory_resource* const res,
+            std::pmr::vector<future<T>>&& inputs) :
+            future_state<when_any_result<T>>{ res, 1 + inputs.size() },
+            futures{ std::move(inputs) },
+            cntArm{ futures.empty() ? size_t{ 1 } : size_t{ 2 } }
+        {}
+
+        virtual ~future_when_any_t()
+        {}
+
+    public:
+        void notifyReady() override
+        {
+            if (!isFired.exchange(true, std::memory_order_acq_rel))
+                arm();
+
+            this->release();
+        }
+
+        void listen()
+        {
+            for (future<T>& input : futures)
+            {
+                if (!input.tryListen(this))
+                    notifyReady();
+            }
+
+            arm();
+        }
+
+    protected:
+        void destroy()
+            noexcept override
+        {
+            generic_allocator{ this->resource }.delete_object(this);
+        }
+
+    private:
+        void arm()
+        {
+            if (cntArm.fetch_sub(1, std::memory_order_acq_rel) != 1)
+                return;
+
+            this->complete([this]
+                {
+                    when_any_result<T> result{ .futures = std::move(futures) };
+                    for (size_t i = 0; i < result.futures.size(); ++i)
+                    {
+                        if (result.futures[i].isReady())
+                        {
+                            result.index = i;
+
+                            break;
+                        }
+                    }
+
+                    return result;
+                });
+        }
+
+    private:
+        std::pmr::vector<future<T>> futures;
+        std::atomic_size_t cntArm;
+        std::atomic_bool isFired{ false };
+    };
+
+    template<class T>
+    future<std::pmr::vector<future<T>>> when_all(std::pmr::vector<future<T>>&& futures)
+    {
+        using state_type = future_when_all_t<T>;
+
+        std::pmr::memory_resource* const res = futures.get_allocator().resource();
+        state_type* const state = generic_allocator{ res }.new_object<state_type>(
+            res, std::move(futures));
+        future<std::pmr::vector<future<T>>> result{ state };
+
+        state->listen();
+
+        return result;
+    }
+
+    template<class T>
+    future<when_any_result<T>> when_any(std::pmr::vector<future<T>>&& futures)
+    {
+        using state_type = future_when_any_t<T>;
+
+        std::pmr::memory_resource* const res = futures.get_allocator().resource();
+        state_type* const state = generic_allocator{ res }.new_object<state_type>(
+            res, std::move(futures));
+        future<when_any_result<T>> result{ state };
+
+        state->listen();
+
+        return result;
+    }
+}
@@ -0,0 +1,13 @@
+#pragma once
+
+#include "clocks.hpp"
+
+namespace mtbase
+{
+    struct idle_policy final
+    {
+        const size_t MAX_SPIN_COUNT;
+        const size_t MAX_YIELD_COUNT;
+        const steady_tick MAX_PARK_TICK;
+    };
+}
@@ -0,0 +1,12 @@
+#pragma once
+
+namespace mtbase
+{
+    enum class overflow_policy :
+        size_t
+    {
+        REJECT,
+        BLOCK,
+        SPILL
+    };
+}
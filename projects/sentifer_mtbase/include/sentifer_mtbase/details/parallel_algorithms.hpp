@@ -0,0 +1,202 @@
+#pragma once
+
+#include <algorithm>
+#include <functional>
+#include <iterator>
+#include <memory_resource>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include "task_group.h"
+
+namespace mtbase
+{
+    constexpr size_t PARALLEL_CHUNK_BYTES = 32 * 1024;
+
+    namespace details
+    {
+        template<class Iter>
+        constexpr auto get_chunk_grain()
+            noexcept
+        {
+            using value_type = typename std::iterator_traits<Iter>::value_type;
+            using difference_type = typename std::iterator_traits<Iter>::difference_type;
+
+            return std::max(difference_type{ 1 },
+                static_cast<difference_type>(PARALLEL_CHUNK_BYTES / sizeof(value_type)));
+        }
+
+        template<class Iter, class T, class BinaryOp>
+        T reduce_chunk(Iter first, const Iter last, T init, BinaryOp& op)
+        {
+            for (; first != last; ++first)
+                init = op(std::move(init), *first);
+
+            return init;
+        }
+
+        template<class Iter, class Compare>
+        void sort_range(
+            task_group& group,
+            Iter first,
+            Iter last,
+            Compare& comp)
+        {
+            using value_type = typename std::iterator_traits<Iter>::value_type;
+
+            constexpr auto grain = get_chunk_grain<Iter>();
+
+            while (last - first > grain)
+            {
+                const Iter mid = first + (last - first) / 2;
+                const value_type pivot = std::max(std::min(*first, *mid, comp),
+                    std::min(std::max(*first, *mid, comp), *std::prev(last), comp), comp);
+
+                const Iter lower = std::partition(first, last,
+                    [&pivot, &comp](const value_type& x) { return comp(x, pivot); });
+                const Iter upper = std::partition(lower, last,
+                    [&pivot, &comp](const value_type& x) { return !comp(pivot, x); });
+
+                if (lower - first < last - upper)
+                {
+                    group.spawn([&group, &comp, first, lower]
+                        {
+                            sort_range(group, first, lower, comp);
+                        });
+                    first = upper;
+                }
+                else
+                {
+                    group.spawn([&group, &comp, upper, last]
+                        {
+                            sort_range(group, upper, last, comp);
+                        });
+                    last = lower;
+                }
+            }
+
+            std::sort(first, last, comp);
+        }
+    }
+
+    template<class Iter, class Func>
+    void for_each(
+        task_group& group,
+        const Iter first,
+        const Iter last,
+        Func&& func)
+    {
+        parallel_for(group, decltype(last - first){ 0 }, last - first,
+            details::get_chunk_grain<Iter>(),
+            [first, &func](const auto i)
+            {
+                std::invoke(func, first[i]);
+            });
+    }
+
+    template<class InIter, class OutIter, class UnaryOp>
+    OutIter transform(
+        task_group& group,
+        const InIter first,
+        const InIter last,
+        const OutIter dest,
+        UnaryOp&& op)
+    {
+        parallel_for(group, decltype(last - first){ 0 }, last - first,
+            details::get_chunk_grain<InIter>(),
+            [first, dest, &op](const auto i)
+            {
+                dest[i] = std::invoke(op, first[i]);
+            });
+
+        return dest + (last - first);
+    }
+
+    template<class Iter, class T, class BinaryOp = std::plus<>>
+    T reduce(
+        task_group& group,
+        const Iter first,
+        const Iter last,
+        T init,
+        BinaryOp op = BinaryOp{})
+    {
+        const auto grain = details::get_chunk_grain<Iter>();
+        const auto cntChunk = (last - first + grain - 1) / grain;
+
+        std::pmr::vector<std::optional<T>> partials(cntChunk, group.getResource());
+        parallel_for(group, decltype(cntChunk){ 0 }, cntChunk, decltype(cntChunk){ 1 },
+            [&](const auto chunk)
+            {
+                const Iter chunkFirst = first + chunk * grain;
+                const Iter chunkLast = last - chunkFirst > grain ? chunkFirst + grain : last;
+
+                partials[chunk].emplace(details::reduce_chunk(
+                    std::next(chunkFirst), chunkLast, T(*chunkFirst), op));
+            });
+
+        for (std::optional<T>& partial : partials)
+            init = op(std::move(init), std::move(*partial));
+
+        return init;
+    }
+
+    template<class InIter, class OutIter, class BinaryOp = std::plus<>>
+    OutIter inclusive_scan(
+        task_group& group,
+        const InIter first,
+        const InIter last,
+        const OutIter dest,
+        BinaryOp op = BinaryOp{})
+    {
+        using value_type = typename std::iterator_traits<InIter>::value_type;
+
+        const auto grain = details::get_chunk_grain<InIter>();
+        const auto cntChunk = (last - first + grain - 1) / grain;
+
+        std::pmr::vector<std::optional<value_type>> carries(cntChunk, group.getResource());
+        parallel_for(group, decltype(cntChunk){ 0 }, cntChunk, decltype(cntChunk){ 1 },
+            [&](const auto chunk)
+            {
+                const InIter chunkFirst = first + chunk * grain;
+                const InIter chunkLast = last - chunkFirst > grain ? chunkFirst + grain : last;
+
+                carries[chunk].emplace(details::reduce_chunk(
+                    std::next(chunkFirst), chunkLast, value_type(*chunkFirst), op));
+            });
+
+        for (size_t i = 1; i < carries.size(); ++i)
+            *carries[i] = op(*carries[i - 1], std::move(*carries[i]));
+
+        parallel_for(group, decltype(cntChunk){ 0 }, cntChunk, decltype(cntChunk){ 1 },
+            [&](const auto chunk)
+            {
+                const InIter chunkFirst = first + chunk * grain;
+                const InIter chunkLast = last - chunkFirst > grain ? chunkFirst + grain : last;
+                OutIter out = dest + chunk * grain;
+
+                value_type sum = chunk == 0 ?
+                    value_type(*chunkFirst) : op(*carries[chunk - 1], *chunkFirst);
+                *out = sum;
+
+                for (InIter it = std::next(chunkFirst); it != chunkLast; ++it)
+                {
+                    sum = op(std::move(sum), *it);
+                    *++out = sum;
+                }
+            });
+
+        return dest + (last - first);
+    }
+
+    template<class Iter, class Compare = std::less<>>
+    void sort(
+        task_group& group,
+        const Iter first,
+        const Iter last,
+        Compare comp = Compare{})
+    {
+        details::sort_range(group, first, last, comp);
+        group.wait();
+    }
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <optional>
+
+#include "clocks.hpp"
+#include "adaptive_policy.h"
+#include "scheduler_restriction.h"
+
+namespace mtbase
+{
+    struct restriction_controller
+    {
+        restriction_controller(const scheduler_restriction& restricts) :
+            tickOccupy{ restricts.MAX_OCCUPY_TICK },
+            tickOccupyFlushing{ restricts.MAX_OCCUPY_TICK_FLUSHING },
+            cntFlush{ restricts.MAX_FLUSH_COUNT },
+            cntFlushAtOnce{ restricts.MAX_FLUSH_COUNT_AT_ONCE }
+        {}
+
+        restriction_controller(
+            const scheduler_restriction& restricts,
+            const adaptive_policy& adaptivePolicy) :
+            restriction_controller{ restricts }
+        {
+            policy.emplace(adaptivePolicy);
+        }
+
+    public:
+        [[nodiscard]]
+        scheduler_restriction getRestriction()
+            const noexcept;
+        [[nodiscard]]
+        bool isAdaptive()
+            const noexcept;
+
+        void recordFlushing(
+            const steady_tick tickBegin,
+            const steady_tick tickEnd,
+            const size_t cntExecuted)
+            noexcept;
+        void update(
+            const size_t cntQueued,
+            const size_t cntBacklogPerWorker)
+            noexcept;
+
+    private:
+        [[nodiscard]]
+        static steady_tick smooth(
+            const steady_tick tickOld,
+            const steady_tick tickNew)
+            noexcept;
+
+    private:
+        static constexpr size_t SMOOTHING_SHIFT = 3;
+
+        std::optional<adaptive_policy> policy;
+        steady_tick tickOccupy;
+        steady_tick tickOccupyFlushing;
+        size_t cntFlush;
+        size_t cntFlushAtOnce;
+        steady_tick tickTaskCost{ steady_tick{} };
+        steady_tick tickSampled{ steady_tick{} };
+        size_t cntSampled{ 0 };
+    };
+}
@@ -0,0 +1,212 @@
+#pragma once
+
+#include <atomic>
+#include <bit>
+#include <memory_resource>
+#include <type_traits>
+#include <variant>
+#include <vector>
+
+#include "../tasks.hpp"
+#include "../schedulers/object_scheduler.h"
+#include "schedulable_object.hpp"
+
+namespace mtbase
+{
+    template<class Derived, class... Msgs>
+    struct schedulable_actor
+    {
+        static_assert(sizeof...(Msgs) > 0);
+
+    private:
+        static constexpr size_t MAX_TASK_STORAGE_SIZE = 4096;
+        static constexpr size_t MAX_DRAIN_COUNT = 64;
+
+        using message_type = std::variant<std::monostate, Msgs...>;
+
+        struct mailbox_slot
+        {
+            std::atomic_size_t sequence{ 0 };
+            message_type message;
+        };
+
+        struct task_mailbox_t :
+            public task_invoke_t
+        {
+            task_mailbox_t(schedulable_actor& actor) :
+                task_invoke_t{},
+                owner{ actor }
+            {}
+
+        public:
+            void invoke() override
+            {
+                owner.drain();
+            }
+
+            [[nodiscard]]
+            bool tryReleaseIntrusive()
+                noexcept override
+            {
+                return true;
+            }
+
+        private:
+            schedulable_actor& owner;
+        };
+
+    public:
+        schedulable_actor(
+            std::pmr::memory_resource* res,
+            object_flush_scheduler& objectFlushSched,
+            const scheduler_restriction&& restricts,
+            const size_t mailboxCapacity) :
+            object{ res, objectFlushSched, std::move(restricts) },
+            slots{ std::bit_ceil(mailboxCapacity), res },
+            MASK{ slots.size() - 1 },
+            mailboxTask{ *this }
+        {
+            for (size_t i = 0; i < slots.size(); ++i)
+                slots[i].sequence.store(i, std::memory_order_relaxed);
+        }
+
+        schedulable_actor(const schedulable_actor&) = delete;
+        schedulable_actor& operator=(const schedulable_actor&) = delete;
+
+    public:
+        template<class Msg>
+        [[nodiscard]]
+        bool tell(Msg&& msg)
+        {
+            static_assert((std::is_same_v<std::decay_t<Msg>, Msgs> || ...));
+
+            size_t pos = tail.load(std::memory_order_relaxed);
+            mailbox_slot* slot = nullptr;
+
+            while (true)
+            {
+                slot = &slots[pos & MASK];
+
+                const size_t sequence = slot->sequence.load(std::memory_order_acquire);
+                const std::ptrdiff_t diff =
+                    static_cast<std::ptrdiff_t>(sequence - pos);
+                if (diff == 0)
+                {
+                    if (tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                        break;
+                }
+                else if (diff < 0)
+                    return false;
+                else
+                    pos = tail.load(std::memory_order_relaxed);
+            }
+
+            slot->message.template emplace<std::decay_t<Msg>>(std::forward<Msg>(msg));
+            slot->sequence.store(pos + 1, std::memory_order_seq_cst);
+
+            activate();
+
+            return true;
+        }
+
+        [[nodiscard]]
+        size_t getMailboxCapacity()
+            const noexcept
+        {
+            return slots.size();
+        }
+
+        [[nodiscard]]
+        object_scheduler* getScheduler()
+            const noexcept
+        {
+            return object.getScheduler();
+        }
+
+    private:
+        void activate()
+        {
+            if (!isDrainScheduled.exchange(true, std::memory_order_seq_cst))
+                object.getScheduler()->registerMailboxTask(&mailboxTask);
+        }
+
+        void drain()
+        {
+            object_scheduler* const sched = object.getScheduler();
+
+            try
+            {
+                for (size_t i = 0;
+                    i < MAX_DRAIN_COUNT && !sched->shouldYield() && tryHandleOne();
+                    ++i);
+            }
+            catch (...)
+            {
+                rearm();
+
+                throw;
+            }
+
+            rearm();
+        }
+
+        [[nodiscard]]
+        bool tryHandleOne()
+        {
+            mailbox_slot& slot = slots[head & MASK];
+            if (slot.sequence.load(std::memory_order_acquire) != head + 1)
+                return false;
+
+            try
+            {
+                std::visit([this](auto& msg)
+                    {
+                        if constexpr (!std::is_same_v<std::decay_t<decltype(msg)>, std::monostate>)
+                            static_cast<Derived*>(this)->handle(msg);
+                    }, slot.message);
+            }
+            catch (...)
+            {
+                releaseSlot(slot);
+
+                throw;
+            }
+
+            releaseSlot(slot);
+
+            return true;
+        }
+
+        void releaseSlot(mailbox_slot& slot)
+            noexcept
+        {
+            slot.message.template emplace<std::monostate>();
+            slot.sequence.store(head + slots.size(), std::memory_order_release);
+            ++head;
+        }
+
+        void rearm()
+        {
+            isDrainScheduled.store(false, std::memory_order_seq_cst);
+
+            if (hasMessage())
+                activate();
+        }
+
+        [[nodiscard]]
+        bool hasMessage()
+            const noexcept
+        {
+            return slots[head & MASK].sequence.load(std::memory_order_seq_cst) == head + 1;
+        }
+
+    private:
+        schedulable_object<MAX_TASK_STORAGE_SIZE> object;
+        std::pmr::vector<mailbox_slot> slots;
+        const size_t MASK;
+        task_mailbox_t mailboxTask;
+        std::atomic_size_t tail{ 0 };
+        size_t head{ 0 };
+        std::atomic_bool isDrainScheduled{ false };
+    };
+}
@@ -3,6 +3,7 @@
 #include "../clocks.hpp"
 #include "../memory_managers.hpp"
 #include "../base_structures.hpp"
+#include "../coroutines.hpp"
 #include "../schedulers/object_scheduler.h"
 
 namespace mtbase
@@ -28,71 +29,318 @@ namespace mtbase
                 restricts);
         };
 
+        schedulable_object(
+            std::pmr::memory_resource* res,
+            object_flush_scheduler& objectFlushSched,
+            const scheduler_restriction&& restricts,
+            const adaptive_policy&& adaptivePolicy) :
+            alloc{ res }
+        {
+            sched = alloc.new_object<object_scheduler>(
+                alloc.resource(),
+                objectFlushSched,
+                alloc.new_object<storage_type>(alloc.resource()),
+                restricts,
+                adaptivePolicy);
+        };
+
+        template<class Func, class... Args>
+        bool scheduleFunc(
+            Func&& func,
+            Args&&... args)
+        {
+            return sched->registerFuncTask(
+                std::forward<Func>(func), std::forward<Args>(args)...);
+        }
+
+        template<class Func, class... Args>
+        bool dispatchFunc(
+            Func&& func,
+            Args&&... args)
+        {
+            return sched->dispatchFuncTask(
+                std::forward<Func>(func), std::forward<Args>(args)...);
+        }
+
+        template<class Func, class... Args>
+        bool scheduleRead(
+            Func&& func,
+            Args&&... args)
+        {
+            return sched->registerReadFuncTask(
+                std::forward<Func>(func), std::forward<Args>(args)...);
+        }
+
+        template<class Func, class... Args>
+        bool scheduleWrite(
+            Func&& func,
+            Args&&... args)
+        {
+            return sched->registerFuncTask(
+                std::forward<Func>(func), std::forward<Args>(args)...);
+        }
+
+        template<class Func, class... Args>
+        void submitFunc(
+            Func&& func,
+            Args&&... args)
+        {
+            sched->submitFuncTask(
+                std::forward<Func>(func), std::forward<Args>(args)...);
+        }
+
+        template<class T, class Method, class... Args>
+        void submitMethod(
+            T* const fromObj,
+            Method&& method,
+            Args&&... args)
+        {
+            sched->submitMethodTask(fromObj,
+                std::forward<Method>(method), std::forward<Args>(args)...);
+        }
+
+        template<class Func, class... Args>
+        bool scheduleCoalesced(
+            const size_t key,
+            Func&& func,
+            Args&&... args)
+        {
+            return sched->registerCoalescedFuncTask(key,
+                std::forward<Func>(func), std::forward<Args>(args)...);
+        }
+
+        template<class Func, class... Args>
+        auto scheduleFuncWithFuture(
+            Func&& func,
+            Args&&... args)
+        {
+            return sched->registerFuncTaskWithFuture(
+                std::forward<Func>(func), std::forward<Args>(args)...);
+        }
+
         template<class Func, class... Args>
-        void scheduleFunc(
+        bool scheduleFuncOnLane(
+            const size_t lane,
             Func&& func,
             Args&&... args)
         {
-            sched->registerFuncTask(
+            return sched->registerFuncTaskOnLane(lane,
                 std::forward<Func>(func), std::forward<Args>(args)...);
         }
 
         template<class Func, class... Args>
-        void scheduleFuncCuttingIn(
+        bool scheduleFuncCuttingIn(
             Func&& func,
             Args&&... args)
         {
-            sched->registerFuncTaskCuttingIn(
+            return sched->registerFuncTaskCuttingIn(
                 std::forward<Func>(func), std::forward<Args>(args)...);
         }
 
         template<class Func, class... Args>
-        void scheduleFuncAfter(
+        timer_handle scheduleFuncAfter(
             steady_tick after,
             Func&& func,
-            Args&&... args);
+            Args&&... args)
+        {
+            return sched->registerFuncTaskAt(
+                clock_t::getSteadyTick() + after, steady_tick{},
+                std::forward<Func>(func), std::forward<Args>(args)...);
+        }
 
         template<class Func, class... Args>
-        void scheduleFuncAt(
+        timer_handle scheduleFuncAt(
             steady_tick at,
             Func&& func,
-            Args&&... args);
+            Args&&... args)
+        {
+            return sched->registerFuncTaskAt(
+                at, steady_tick{},
+                std::forward<Func>(func), std::forward<Args>(args)...);
+        }
+
+        template<class Func, class... Args>
+        timer_handle scheduleFuncEvery(
+            steady_tick period,
+            Func&& func,
+            Args&&... args)
+        {
+            return sched->registerFuncTaskAt(
+                clock_t::getSteadyTick() + period, period,
+                std::forward<Func>(func), std::forward<Args>(args)...);
+        }
+
+        template<class T, class Method, class... Args>
+        bool scheduleMethod(
+            T* const fromObj,
+            Method&& method,
+            Args&&... args)
+        {
+            return sched->registerMethodTask(fromObj,
+                std::forward<Method>(method), std::forward<Args>(args)...);
+        }
+
+        template<class T, class Method, class... Args>
+        bool scheduleReadMethod(
+            T* const fromObj,
+            Method&& method,
+            Args&&... args)
+        {
+            return sched->registerReadMethodTask(fromObj,
+                std::forward<Method>(method), std::forward<Args>(args)...);
+        }
+
+        template<class T, class Method, class... Args>
+        bool scheduleWriteMethod(
+            T* const fromObj,
+            Method&& method,
+            Args&&... args)
+        {
+            return sched->registerMethodTask(fromObj,
+                std::forward<Method>(method), std::forward<Args>(args)...);
+        }
 
         template<class T, class Method, class... Args>
-        void scheduleMethod(
+        bool dispatchMethod(
             T* const fromObj,
             Method&& method,
             Args&&... args)
         {
-            sched->registerMethodTask(fromObj,
+            return sched->dispatchMethodTask(fromObj,
                 std::forward<Method>(method), std::forward<Args>(args)...);
         }
 
         template<class T, class Method, class... Args>
-        void scheduleMethodCuttingIn(
+        auto scheduleMethodWithFuture(
             T* const fromObj,
             Method&& method,
             Args&&... args)
         {
-            sched->registerMethodTaskCuttingIn(fromObj,
+            return sched->registerMethodTaskWithFuture(fromObj,
                 std::forward<Method>(method), std::forward<Args>(args)...);
         }
 
         template<class T, class Method, class... Args>
-        void scheduleMethodAfter(
+        bool scheduleMethodOnLane(
+            const size_t lane,
+            T* const fromObj,
+            Method&& method,
+            Args&&... args)
+        {
+            return sched->registerMethodTaskOnLane(lane, fromObj,
+                std::forward<Method>(method), std::forward<Args>(args)...);
+        }
+
+        template<class T, class Method, class... Args>
+        bool scheduleMethodCuttingIn(
+            T* const fromObj,
+            Method&& method,
+            Args&&... args)
+        {
+            return sched->registerMethodTaskCuttingIn(fromObj,
+                std::forward<Method>(method), std::forward<Args>(args)...);
+        }
+
+        template<class T, class Method, class... Args>
+        timer_handle scheduleMethodAfter(
             steady_tick after,
             T* const fromObj,
             Method&& method,
-            Args&&... args);
+            Args&&... args)
+        {
+            return sched->registerMethodTaskAt(
+                clock_t::getSteadyTick() + after, steady_tick{}, fromObj,
+                std::forward<Method>(method), std::forward<Args>(args)...);
+        }
 
         template<class T, class Method, class... Args>
-        void scheduleMethodAt(
+        timer_handle scheduleMethodAt(
             steady_tick at,
             T* const fromObj,
             Method&& method,
-            Args&&... args);
+            Args&&... args)
+        {
+            return sched->registerMethodTaskAt(
+                at, steady_tick{}, fromObj,
+                std::forward<Method>(method), std::forward<Args>(args)...);
+        }
+
+        template<class T, class Method, class... Args>
+        timer_handle scheduleMethodEvery(
+            steady_tick period,
+            T* const fromObj,
+            Method&& method,
+            Args&&... args)
+        {
+            return sched->registerMethodTaskAt(
+                clock_t::getSteadyTick() + period, period, fromObj,
+                std::forward<Method>(method), std::forward<Args>(args)...);
+        }
+
+        void setOverflowPolicy(const overflow_policy policy)
+            noexcept
+        {
+            sched->setOverflowPolicy(policy);
+        }
+
+        [[nodiscard]]
+        size_t addPriorityLane(const size_t weight)
+        {
+            return sched->addPriorityLane<storage_type>(weight);
+        }
+
+        template<class Target, class T, class Method, class Reply, class... Args>
+        void ask(
+            Target& target,
+            T* const fromObj,
+            Method&& method,
+            Reply&& replied,
+            Args&&... args)
+        {
+            target.getScheduler()->registerAskTask(sched, fromObj,
+                std::forward<Method>(method), std::forward<Reply>(replied),
+                std::forward<Args>(args)...);
+        }
 
-        bool tryTransferAuthority(task_transaction_t* const task);
+        template<class Target, class T, class Method, class Reply, class... Args>
+        void askFor(
+            Target& target,
+            const steady_tick timeout,
+            T* const fromObj,
+            Method&& method,
+            Reply&& replied,
+            Args&&... args)
+        {
+            target.getScheduler()->registerAskTaskFor(sched, timeout, fromObj,
+                std::forward<Method>(method), std::forward<Reply>(replied),
+                std::forward<Args>(args)...);
+        }
+
+        [[nodiscard]]
+        schedule_awaiter schedule()
+            const noexcept
+        {
+            return schedule_awaiter{ *sched };
+        }
+
+        [[nodiscard]]
+        after_awaiter after(const steady_tick tickAfter)
+            const noexcept
+        {
+            return after_awaiter{ *sched, tickAfter };
+        }
+
+        bool tryTransferAuthority(task_transaction_t* const task)
+        {
+            return sched->tryTransferAuthority(task);
+        }
+
+        [[nodiscard]]
+        object_scheduler* getScheduler()
+            const noexcept
+        {
+            return sched;
+        }
 
     private:
         generic_allocator alloc;
@@ -18,46 +18,50 @@ namespace mtbase
 
     public:
         template<class Func, class... Args>
-        void registerFuncTask(Func&& func, Args&&... args)
+        bool registerFuncTask(Func&& func, Args&&... args)
         {
-            registerTaskImpl(alloc.new_func_task(
+            return registerTaskImpl(alloc.new_func_task(
                 std::forward<Func>(func),
-                std::forward_as_tuple(std::forward<Args>(args)...)));
+                std::make_tuple(std::forward<Args>(args)...)));
         }
 
         template<class Func, class... Args>
-        void registerFuncTaskCuttingIn(Func&& func, Args&&... args)
+        bool registerFuncTaskCuttingIn(Func&& func, Args&&... args)
         {
-            registerTaskCuttingInImpl(alloc.new_func_task(
+            return registerTaskCuttingInImpl(alloc.new_func_task(
                 std::forward<Func>(func),
-                std::forward_as_tuple(std::forward<Args>(args)...)));
+                std::make_tuple(std::forward<Args>(args)...)));
         }
 
         template<class T, class Method, class... Args>
-        void registerMethodTask(T* const fromObj, Method&& method, Args&&... args)
+        bool registerMethodTask(T* const fromObj, Method&& method, Args&&... args)
         {
-            registerTaskImpl(alloc.new_method_task(
+            return registerTaskImpl(alloc.new_method_task(
                 fromObj, std::forward<Method>(method),
-                std::forward_as_tuple(std::forward<Args>(args)...)));
+                std::make_tuple(std::forward<Args>(args)...)));
         }
 
         template<class T, class Method, class... Args>
-        void registerMethodTaskCuttingIn(T* const fromObj, Method&& method, Args&&... args)
+        bool registerMethodTaskCuttingIn(T* const fromObj, Method&& method, Args&&... args)
         {
-            registerTaskCuttingInImpl(alloc.new_method_task(
+            return registerTaskCuttingInImpl(alloc.new_method_task(
                 fromObj, std::forward<Method>(method),
-                std::forward_as_tuple(std::forward<Args>(args)...)));
+                std::make_tuple(std::forward<Args>(args)...)));
         }
 
     protected:
-        virtual void registerTaskImpl(task_invoke_t* const task)
+        virtual bool registerTaskImpl(task_invoke_t* const task)
         {
             alloc.delete_task(task);
+
+            return false;
         }
 
-        virtual void registerTaskCuttingInImpl(task_invoke_t* const task)
+        virtual bool registerTaskCuttingInImpl(task_invoke_t* const task)
         {
             alloc.delete_task(task);
+
+            return false;
         }
     };
 }
\ No newline at end of file
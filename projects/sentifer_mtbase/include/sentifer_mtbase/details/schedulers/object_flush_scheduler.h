@@ -1,38 +1,181 @@
 #pragma once
+#include <atomic>
+#include <deque>
 #include <memory_resource>
+#include <mutex>
+#include <span>
+#include <vector>
 
 #include "../scheduler.hpp"
 #include "../scheduler_restriction.h"
+#include "../event_count.h"
 
 namespace mtbase
 {
     struct thread_local_scheduler;
     struct control_block;
 
+    struct affinity_statistics final
+    {
+        [[nodiscard]]
+        double getHitRatio()
+            const noexcept
+        {
+            const size_t cntTotal = cntHit + cntMigrated;
+
+            return cntTotal == 0 ? 1.0 : static_cast<double>(cntHit) / cntTotal;
+        }
+
+        size_t cntHit{ 0 };
+        size_t cntMigrated{ 0 };
+    };
+
     struct object_flush_scheduler final :
         public scheduler
     {
         object_flush_scheduler(
             std::pmr::memory_resource* const res,
             task_storage* const taskStorage,
-            const scheduler_restriction&& restricts) :
+            std::span<task_storage* const> shardStorages,
+            std::span<task_storage* const> deadlineStorages,
+            const scheduler_restriction&& restricts,
+            const size_t maxAffinityBacklog,
+            const steady_tick deadlineBucketTick) :
             scheduler{ res, taskStorage },
-            restriction{ restricts }
+            shards{ shardStorages.begin(), shardStorages.end(), res },
+            deadlineBuckets{ deadlineStorages.begin(), deadlineStorages.end(), res },
+            workers{ shardStorages.size(), res },
+            injectedTasks{ res },
+            spilledTasks{ res },
+            restriction{ restricts },
+            MAX_AFFINITY_BACKLOG{ maxAffinityBacklog },
+            DEADLINE_BUCKET_TICK{ deadlineBucketTick }
         {}
 
-        virtual ~object_flush_scheduler()
-        {}
+        virtual ~object_flush_scheduler();
 
     public:
+        template<class Func, class... Args>
+        void injectFuncTask(Func&& func, Args&&... args)
+        {
+            injectTask(alloc.new_func_task(
+                std::forward<Func>(func),
+                std::make_tuple(std::forward<Args>(args)...)));
+        }
+
+        template<class T, class Method, class... Args>
+        void injectMethodTask(T* const fromObj, Method&& method, Args&&... args)
+        {
+            injectTask(alloc.new_method_task(
+                fromObj, std::forward<Method>(method),
+                std::make_tuple(std::forward<Args>(args)...)));
+        }
+
+        void injectTask(task_invoke_t* const task);
+        [[nodiscard]]
+        task_t* popInjectedTask();
+        [[nodiscard]]
+        bool hasInjectedTask()
+            const noexcept;
+
         void registerFlushObjectTask(object_scheduler* const objectSched);
-        void flush(thread_local_scheduler& threadSched);
+        void registerYieldedFlushObjectTask(object_scheduler* const objectSched);
+        void registerNextFlushObjectTask(object_scheduler* const objectSched);
+        void registerFlushObjectTask(
+            object_scheduler* const objectSched,
+            const steady_tick tickPendingSince);
+        [[nodiscard]]
+        bool flush(
+            thread_local_scheduler& threadSched,
+            const bool isStarving);
+
+        void attachWorker(thread_local_scheduler& threadSched)
+            noexcept;
+        void detachWorker(thread_local_scheduler& threadSched)
+            noexcept;
+        void registerReadTask(task_invoke_t* const task);
+        [[nodiscard]]
+        bool tryRegisterGroupTask(task_invoke_t* const task);
+        [[nodiscard]]
+        task_t* stealGroupTask(const thread_local_scheduler& threadSched);
+
+        void wakeWorker();
+        void requestStop();
+        [[nodiscard]]
+        bool isStopRequested()
+            const noexcept;
+        [[nodiscard]]
+        event_count& getIdleEvent()
+            noexcept;
+        [[nodiscard]]
+        idle_statistics getIdleStatistics()
+            const noexcept;
+
+        void recordAffinity(const bool isHit)
+            noexcept;
+        [[nodiscard]]
+        affinity_statistics getAffinityStatistics()
+            const noexcept;
+        [[nodiscard]]
+        size_t getBacklogPerWorker()
+            const noexcept;
 
     protected:
-        void registerTaskImpl(task_flush_object_t* const task);
+        void registerTaskImpl(
+            task_flush_object_t* const task,
+            const size_t preferredWorkerIndex);
 
     private:
-        void flushTasks(control_block& block);
-        void executeTask(control_block& block);
+        [[nodiscard]]
+        bool flushTasks(
+            thread_local_scheduler& threadSched,
+            control_block& block,
+            const bool isStarving);
+        [[nodiscard]]
+        bool executeTask(
+            thread_local_scheduler& threadSched,
+            control_block& block,
+            const bool isStarving);
+        [[nodiscard]]
+        task_t* popTask(
+            thread_local_scheduler& threadSched,
+            const bool isStarving);
+        [[nodiscard]]
+        task_t* popQueuedTask(
+            thread_local_scheduler& threadSched,
+            const bool isStarving);
+        [[nodiscard]]
+        task_t* popLateTask(size_t& bucketIndex);
+        [[nodiscard]]
+        bool hasSharedTask()
+            const noexcept;
+        void pushSharedTask(task_flush_object_t* const task);
+        void spillTask(task_flush_object_t* const task);
+        [[nodiscard]]
+        task_t* popSpilledTask();
+        [[nodiscard]]
+        task_t* stealTask(
+            const size_t shardIndex,
+            const bool isStarving);
+
+        [[nodiscard]]
+        task_storage* getLocalShard()
+            const noexcept;
+        [[nodiscard]]
+        task_storage* getPreferredShard(const size_t preferredWorkerIndex)
+            const noexcept;
+        [[nodiscard]]
+        size_t getDeadlineLevel(const steady_tick tickPendingSince)
+            const noexcept;
+        [[nodiscard]]
+        steady_tick makeDeadline(const size_t level)
+            const noexcept;
+        [[nodiscard]]
+        static steady_tick getDeadline(const task_t* const task)
+            noexcept;
+        [[nodiscard]]
+        size_t getShardIndex(const thread_local_scheduler& threadSched)
+            const noexcept;
 
         void invokeTask(
             control_block& block,
@@ -44,6 +187,22 @@ namespace mtbase
             const;
 
     private:
+        std::pmr::vector<task_storage*> shards;
+        std::pmr::vector<task_storage*> deadlineBuckets;
+        std::pmr::vector<std::atomic<thread_local_scheduler*>> workers;
+        std::atomic_size_t idxNextWorker{ 0 };
+        std::mutex injectorMutex;
+        std::pmr::deque<task_t*> injectedTasks;
+        std::atomic_size_t cntInjected{ 0 };
+        std::mutex spillMutex;
+        std::pmr::deque<task_t*> spilledTasks;
+        std::atomic_size_t cntSpilled{ 0 };
         const scheduler_restriction restriction;
+        const size_t MAX_AFFINITY_BACKLOG;
+        const steady_tick DEADLINE_BUCKET_TICK;
+        event_count idleEvent;
+        std::atomic_bool isStopping{ false };
+        std::atomic_size_t cntAffinityHit{ 0 };
+        std::atomic_size_t cntAffinityMigrated{ 0 };
     };
 }
@@ -1,7 +1,21 @@
 #pragma once
 
+#include <array>
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <limits>
+#include <memory_resource>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
 #include "../clocks.hpp"
+#include "../mtbase_assert.h"
+#include "../overflow_policy.h"
 #include "../scheduler_restriction.h"
+#include "../restriction_controller.h"
+#include "../timer_handle.h"
 #include "invocable_scheduler.h"
 
 namespace mtbase
@@ -20,25 +34,501 @@ namespace mtbase
             const scheduler_restriction& restricts) :
             invocable_scheduler{ res, taskStorage },
             flusher{ objectFlushSched },
-            restriction{ restricts }
-        {}
+            controller{ restricts },
+            lanes{ res },
+            coalescedTasks{ res },
+            ownedTasks{ res },
+            submittedTasks{ res }
+        {
+            lanes.emplace_back(res, taskStorage, 1, nullptr);
+        }
 
-        virtual ~object_scheduler()
-        {}
+        object_scheduler(
+            std::pmr::memory_resource* const res,
+            object_flush_scheduler& objectFlushSched,
+            task_storage* const taskStorage,
+            const scheduler_restriction& restricts,
+            const adaptive_policy& adaptivePolicy) :
+            invocable_scheduler{ res, taskStorage },
+            flusher{ objectFlushSched },
+            controller{ restricts, adaptivePolicy },
+            lanes{ res },
+            coalescedTasks{ res },
+            ownedTasks{ res },
+            submittedTasks{ res }
+        {
+            lanes.emplace_back(res, taskStorage, 1, nullptr);
+        }
+
+        virtual ~object_scheduler();
 
     public:
+        static constexpr size_t NO_WORKER_INDEX = std::numeric_limits<size_t>::max();
+
+        template<class Func, class... Args>
+        timer_handle registerFuncTaskAt(
+            const steady_tick at,
+            const steady_tick period,
+            Func&& func,
+            Args&&... args)
+        {
+            return registerTimedTaskImpl(alloc.new_func_task(
+                std::forward<Func>(func),
+                std::make_tuple(std::forward<Args>(args)...)),
+                at, period);
+        }
+
+        template<class T, class Method, class... Args>
+        timer_handle registerMethodTaskAt(
+            const steady_tick at,
+            const steady_tick period,
+            T* const fromObj,
+            Method&& method,
+            Args&&... args)
+        {
+            return registerTimedTaskImpl(alloc.new_method_task(
+                fromObj, std::forward<Method>(method),
+                std::make_tuple(std::forward<Args>(args)...)),
+                at, period);
+        }
+
+        template<class Func, class... Args>
+        auto registerFuncTaskWithFuture(
+            Func&& func,
+            Args&&... args)
+        {
+            auto* const task = alloc.new_future_func_task(
+                std::forward<Func>(func),
+                std::make_tuple(std::forward<Args>(args)...));
+            future<typename std::remove_pointer_t<decltype(task)>::result_type> result{ task };
+
+            registerInternalTaskImpl(task);
+
+            return result;
+        }
+
+        template<class T, class Method, class... Args>
+        auto registerMethodTaskWithFuture(
+            T* const fromObj,
+            Method&& method,
+            Args&&... args)
+        {
+            auto* const task = alloc.new_future_method_task(
+                fromObj, std::forward<Method>(method),
+                std::make_tuple(std::forward<Args>(args)...));
+            future<typename std::remove_pointer_t<decltype(task)>::result_type> result{ task };
+
+            registerInternalTaskImpl(task);
+
+            return result;
+        }
+
+        template<class T, class Method, class Reply, class... Args>
+        void registerAskTask(
+            object_scheduler* const replySched,
+            T* const fromObj,
+            Method&& method,
+            Reply&& replied,
+            Args&&... args)
+        {
+            registerInternalTaskImpl(alloc.new_ask_task<false>(
+                replySched, fromObj, std::forward<Method>(method),
+                std::forward<Reply>(replied),
+                std::make_tuple(std::forward<Args>(args)...)));
+        }
+
+        template<class T, class Method, class Reply, class... Args>
+        void registerAskTaskFor(
+            object_scheduler* const replySched,
+            const steady_tick timeout,
+            T* const fromObj,
+            Method&& method,
+            Reply&& replied,
+            Args&&... args)
+        {
+            task_ask_base_t* const task = alloc.new_ask_task<true>(
+                replySched, fromObj, std::forward<Method>(method),
+                std::forward<Reply>(replied),
+                std::make_tuple(std::forward<Args>(args)...));
+
+            task->armTimeout(clock_t::getSteadyTick() + timeout);
+            registerInternalTaskImpl(task);
+        }
+
+        template<class Func, class... Args>
+        bool dispatchFuncTask(Func&& func, Args&&... args)
+        {
+            if (!tryDispatch())
+                return registerFuncTask(
+                    std::forward<Func>(func), std::forward<Args>(args)...);
+
+            invokeDispatched([&]
+                {
+                    std::invoke(std::forward<Func>(func), std::forward<Args>(args)...);
+                });
+
+            return true;
+        }
+
+        template<class T, class Method, class... Args>
+        bool dispatchMethodTask(T* const fromObj, Method&& method, Args&&... args)
+        {
+            if (!tryDispatch())
+                return registerMethodTask(fromObj,
+                    std::forward<Method>(method), std::forward<Args>(args)...);
+
+            invokeDispatched([&]
+                {
+                    std::invoke(std::forward<Method>(method), fromObj,
+                        std::forward<Args>(args)...);
+                });
+
+            return true;
+        }
+
+        template<class Func, class... Args>
+        bool registerCoalescedFuncTask(
+            const size_t key,
+            Func&& func,
+            Args&&... args)
+        {
+            return registerCoalescedTaskImpl(key, alloc.new_func_task(
+                std::forward<Func>(func),
+                std::make_tuple(std::forward<Args>(args)...)));
+        }
+
+        template<class Func, class... Args>
+        bool registerReadFuncTask(Func&& func, Args&&... args)
+        {
+            return registerReadTaskImpl(alloc.new_read_task(this,
+                std::forward<Func>(func),
+                std::make_tuple(std::forward<Args>(args)...)));
+        }
+
+        template<class T, class Method, class... Args>
+        bool registerReadMethodTask(T* const fromObj, Method&& method, Args&&... args)
+        {
+            return registerReadTaskImpl(alloc.new_read_task(this,
+                std::forward<Method>(method),
+                std::make_tuple(fromObj, std::forward<Args>(args)...)));
+        }
+
+        template<class Func, class... Args>
+        void submitFuncTask(Func&& func, Args&&... args)
+        {
+            submitTaskImpl(alloc.new_func_task(
+                std::forward<Func>(func),
+                std::make_tuple(std::forward<Args>(args)...)));
+        }
+
+        template<class T, class Method, class... Args>
+        void submitMethodTask(T* const fromObj, Method&& method, Args&&... args)
+        {
+            submitTaskImpl(alloc.new_method_task(
+                fromObj, std::forward<Method>(method),
+                std::make_tuple(std::forward<Args>(args)...)));
+        }
+
+        template<class Func, class... Args>
+        void registerContinuationTask(Func&& func, Args&&... args)
+        {
+            if (current() == this)
+                isYieldRequested = true;
+
+            registerInternalTaskImpl(alloc.new_func_task(
+                std::forward<Func>(func),
+                std::make_tuple(std::forward<Args>(args)...)));
+        }
+
+        template<class Func, class... Args>
+        bool registerFuncTaskOnLane(
+            const size_t lane,
+            Func&& func,
+            Args&&... args)
+        {
+            return registerTaskOnLaneImpl(lane, alloc.new_func_task(
+                std::forward<Func>(func),
+                std::make_tuple(std::forward<Args>(args)...)));
+        }
+
+        template<class T, class Method, class... Args>
+        bool registerMethodTaskOnLane(
+            const size_t lane,
+            T* const fromObj,
+            Method&& method,
+            Args&&... args)
+        {
+            return registerTaskOnLaneImpl(lane, alloc.new_method_task(
+                fromObj, std::forward<Method>(method),
+                std::make_tuple(std::forward<Args>(args)...)));
+        }
+
+        template<class Storage>
+        [[nodiscard]]
+        size_t addPriorityLane(const size_t weight)
+        {
+            generic_allocator storageAlloc{ lanes.get_allocator().resource() };
+
+            return addPriorityLaneImpl(
+                storageAlloc.new_object<Storage>(storageAlloc.resource()), weight,
+                [](std::pmr::memory_resource* const res, task_storage* const laneStorage)
+                {
+                    generic_allocator{ res }.delete_object(static_cast<Storage*>(laneStorage));
+                });
+        }
+
+        void setOverflowPolicy(const overflow_policy policy)
+            noexcept;
+        void registerResumeTask(task_resume_t* const task);
+        void registerFutureTask(task_invoke_t* const task);
+        void registerAskTask(task_ask_base_t* const task);
+        void registerMailboxTask(task_invoke_t* const task);
+        void registerBatchTask(task_invoke_t* const task);
+        [[nodiscard]]
+        timer_handle registerAskTimeoutTask(
+            const steady_tick at,
+            task_invoke_t* const task);
+        void registerResumeTaskAt(
+            const steady_tick at,
+            task_resume_t* const task,
+            timer_handle& handle);
+        void registerExpiredTask(task_timed_invoke_t* const task);
+        void registerTransactionTask(task_transaction_t* const task);
+        void endRead();
         void flush(thread_local_scheduler& threadSched);
 
+        [[nodiscard]]
+        bool tryTransferAuthority(task_transaction_t* const task)
+            noexcept;
+        void resumeAuthority();
+
+        [[nodiscard]]
+        size_t getLastWorkerIndex()
+            const noexcept;
+
+        [[nodiscard]]
+        static object_scheduler* current()
+            noexcept;
+        [[nodiscard]]
+        static object_scheduler* exchangeCurrent(object_scheduler* const sched)
+            noexcept;
+        static void flushSubmits();
+        static void flushExpiredSubmits();
+        [[nodiscard]]
+        static steady_tick getSubmitDeadline()
+            noexcept;
+        [[nodiscard]]
+        bool shouldYield()
+            const noexcept;
+
     protected:
-        void registerTaskImpl(task_invoke_t* const task)
+        bool registerTaskImpl(task_invoke_t* const task)
             override;
-        void registerTaskCuttingInImpl(task_invoke_t* const task)
+        bool registerTaskCuttingInImpl(task_invoke_t* const task)
             override;
 
     private:
+        using lane_storage_deleter =
+            void (*)(std::pmr::memory_resource* const, task_storage* const);
+
+        struct priority_lane
+        {
+            priority_lane(
+                std::pmr::memory_resource* const res,
+                task_storage* const laneStorage,
+                const size_t laneWeight,
+                const lane_storage_deleter laneDeleter) :
+                storage{ laneStorage },
+                weight{ laneWeight },
+                deleter{ laneDeleter },
+                overflowTasks{ res }
+            {}
+
+            task_storage* const storage;
+            const size_t weight;
+            const lane_storage_deleter deleter;
+            std::ptrdiff_t credit{ 0 };
+            std::mutex overflowMutex;
+            std::pmr::deque<task_t*> overflowTasks;
+            std::atomic_size_t cntOverflow{ 0 };
+            // Cut-in tasks at the front of overflowTasks, which run before
+            // the lane's storage.
+            std::atomic_size_t cntOverflowCuttingIn{ 0 };
+        };
+
+        static constexpr size_t MAX_SUBMIT_BATCH_SIZE = 64;
+        static constexpr size_t MAX_SUBMIT_TARGET_COUNT = 8;
+        static constexpr steady_tick MAX_SUBMIT_DELAY_TICK = std::chrono::microseconds{ 100 };
+
+        // Tasks one thread submitted to one object. Only the owning thread
+        // appends; any thread may seal the entry to commit it, after which
+        // the owner's next append fails and waits for the entry to be freed.
+        struct submit_entry
+        {
+            static constexpr size_t STATE_SEALED = size_t{ 1 } << 62;
+            static constexpr size_t STATE_FREE = size_t{ 1 } << 63;
+
+        public:
+            std::atomic_size_t state{ STATE_FREE };
+            std::atomic<object_scheduler*> target{ nullptr };
+            std::atomic<steady_tick::rep> tickFirst{ 0 };
+            std::array<task_invoke_t*, MAX_SUBMIT_BATCH_SIZE> tasks{};
+        };
+
+        struct submit_queue
+        {
+            std::array<submit_entry, MAX_SUBMIT_TARGET_COUNT> entries;
+            std::atomic_size_t cntPending{ 0 };
+            size_t idxEvicted{ 0 };
+        };
+
+        struct submit_registry
+        {
+            std::mutex mutex;
+            std::vector<submit_queue*> queues;
+            std::atomic<steady_tick::rep> tickDeadline{ steady_tick::max().count() };
+        };
+
+        struct submit_queue_owner
+        {
+            ~submit_queue_owner();
+
+            submit_queue* queue{ nullptr };
+        };
+
+    private:
+        [[nodiscard]]
+        size_t addPriorityLaneImpl(
+            task_storage* const laneStorage,
+            const size_t weight,
+            const lane_storage_deleter deleter);
+        bool registerTaskOnLaneImpl(
+            const size_t lane,
+            task_invoke_t* const task);
+        void registerInternalTaskImpl(task_invoke_t* const task);
+        bool registerCoalescedTaskImpl(
+            const size_t key,
+            task_invoke_t* const task);
+        void invokeCoalesced(const size_t key);
+        bool registerReadTaskImpl(task_read_base_t* const task);
+        void beginRead(task_read_base_t* const task);
+        void parkForReaders();
+        void resumeFromReaders();
+        void submitTaskImpl(task_invoke_t* const task);
+        [[nodiscard]]
+        submit_entry& acquireSubmitEntry(submit_queue& queue);
+        void commitSubmits(task_invoke_t* const* const tasks, const size_t cnt);
+        void invokeSubmitted(const std::pmr::vector<task_invoke_t*>& tasks);
+        void discardSubmits()
+            noexcept;
+        [[nodiscard]]
+        task_t* popSubmittedTask()
+            noexcept;
+        [[nodiscard]]
+        static bool trySealEntry(submit_entry& entry, size_t& cnt)
+            noexcept;
+        static void freeEntry(submit_queue& queue, submit_entry& entry, const size_t cnt)
+            noexcept;
+        static bool tryCommitEntry(submit_queue& queue, submit_entry& entry);
+        static void commitQueue(submit_queue& queue);
+        [[nodiscard]]
+        static bool updateSubmitDeadline(const steady_tick tickDeadline)
+            noexcept;
+        [[nodiscard]]
+        static submit_queue& getLocalSubmitQueue();
+        [[nodiscard]]
+        static submit_registry& getSubmitRegistry()
+            noexcept;
+        bool pushTask(
+            priority_lane& lane,
+            task_invoke_t* const task,
+            const bool isCuttingIn,
+            const overflow_policy onOverflow);
+        [[nodiscard]]
+        bool tryPushTask(
+            priority_lane& lane,
+            task_invoke_t* const task,
+            const bool isCuttingIn);
+        [[nodiscard]]
+        bool handleOverflow(
+            priority_lane& lane,
+            task_invoke_t* const task,
+            const bool isCuttingIn,
+            const overflow_policy onOverflow);
+        void pushTaskWithBackoff(
+            priority_lane& lane,
+            task_invoke_t* const task,
+            const bool isCuttingIn);
+        void spillTask(
+            priority_lane& lane,
+            task_invoke_t* const task,
+            const bool isCuttingIn);
+        [[nodiscard]]
+        task_t* popLaneTask(priority_lane& lane);
+        [[nodiscard]]
+        task_t* popOverflowTask(priority_lane& lane);
+        [[nodiscard]]
+        timer_handle registerTimedTaskImpl(
+            task_invoke_t* const task,
+            const steady_tick at,
+            const steady_tick period);
+        void registerTimedTaskImpl(
+            task_invoke_t* const task,
+            const steady_tick at,
+            const steady_tick period,
+            timer_handle& handle);
+        void activate();
         void flushOwned(thread_local_scheduler& threadSched);
-        void flushTasks(control_block& block);
-        void executeTask(control_block& block);
+        void continueOwned();
+        [[nodiscard]]
+        bool tryDispatch();
+        void finishDispatch();
+
+        template<class Invoke>
+        void invokeDispatched(Invoke&& invoked)
+        {
+            try
+            {
+                invoked();
+            }
+            catch (...)
+            {
+                finishDispatch();
+
+                throw;
+            }
+
+            finishDispatch();
+        }
+        [[nodiscard]]
+        bool flushTasks(
+            control_block& block,
+            const scheduler_restriction& restriction,
+            size_t& cntExecuted);
+        [[nodiscard]]
+        bool executeTask(
+            control_block& block,
+            const scheduler_restriction& restriction);
+        [[nodiscard]]
+        task_t* popTask();
+        [[nodiscard]]
+        task_t* popQueuedTask();
+        [[nodiscard]]
+        task_t* popOwnedTask()
+            noexcept;
+        void spillOwnedTasks();
+        [[nodiscard]]
+        size_t getQueuedCount()
+            const noexcept;
+        void adapt()
+            noexcept;
+        [[nodiscard]]
+        steady_tick getOldestPendingTick()
+            noexcept;
+        void stampPending()
+            noexcept;
+        void beginBacklog()
+            noexcept;
 
         void invokeTask(
             control_block& block,
@@ -49,14 +539,75 @@ namespace mtbase
             task_invoke_t* const task)
             const;
 
+        [[nodiscard]]
         bool tryOwn()
             noexcept;
+        [[nodiscard]]
+        bool tryIdle()
+            noexcept;
         void release()
             noexcept;
 
     private:
-        std::atomic_bool isOwned{ false };
+        static constexpr size_t STATE_IDLE = 0;
+        static constexpr size_t STATE_SCHEDULED = 1 << 0;
+        static constexpr size_t STATE_RUNNING = 1 << 1;
+
+        static constexpr size_t MAX_BACKOFF_SPIN_COUNT = 16;
+        static constexpr size_t MAX_BACKOFF_YIELD_COUNT = 16;
+        static constexpr steady_tick MAX_BACKOFF_SLEEP_TICK = std::chrono::milliseconds{ 1 };
+
+        static constexpr size_t MAX_DISPATCH_DEPTH = 16;
+        static constexpr size_t MAX_OWNED_TASK_COUNT = 256;
+
+        static constexpr uint64_t YIELD_CHECK_CYCLE_COUNT = 1 << 14;
+
+        static thread_local object_scheduler* currentSched;
+        static thread_local size_t cntDispatchDepth;
+        static thread_local submit_queue_owner localSubmitQueue;
+
+        std::atomic_size_t state{ STATE_IDLE };
+        std::atomic_size_t lastWorkerIndex{ NO_WORKER_INDEX };
+        std::atomic<steady_tick::rep> tickPendingSince{ 0 };
+        task_transaction_t* transferTask{ nullptr };
+        steady_tick tickBacklogSince{ steady_tick{} };
+        size_t cntBacklog{ 0 };
+        size_t cntBacklogExecuted{ 0 };
+        const control_block* runningBlock{ nullptr };
+        const scheduler_restriction* runningRestriction{ nullptr };
+        object_scheduler* dispatchingSched{ nullptr };
+        bool isYieldRequested{ false };
+        mutable bool isYieldExpired{ false };
+        mutable uint64_t cycleYieldChecked{ 0 };
         object_flush_scheduler& flusher;
-        const scheduler_restriction restriction;
+        restriction_controller controller;
+        std::pmr::deque<priority_lane> lanes;
+        overflow_policy overflowPolicy{ overflow_policy::REJECT };
+        std::mutex coalesceMutex;
+        std::pmr::unordered_map<size_t, task_invoke_t*> coalescedTasks;
+        std::pmr::vector<task_invoke_t*> ownedTasks;
+        size_t idxOwnedTask{ 0 };
+        std::pmr::vector<task_invoke_t*> submittedTasks;
+        size_t idxSubmittedTask{ 0 };
+        task_t* blockedTask{ nullptr };
+        bool isWaitingReaders{ false };
+        std::atomic_size_t cntReading{ 0 };
+        std::atomic_bool isParkedForReaders{ false };
     };
+
+    [[nodiscard]]
+    bool should_yield()
+        noexcept;
+
+    void flush_submits();
+
+    template<class Func, class... Args>
+    void yield_with(Func&& func, Args&&... args)
+    {
+        object_scheduler* const sched = object_scheduler::current();
+        MTBASE_ASSERT(sched != nullptr);
+
+        sched->registerContinuationTask(
+            std::forward<Func>(func), std::forward<Args>(args)...);
+    }
 }
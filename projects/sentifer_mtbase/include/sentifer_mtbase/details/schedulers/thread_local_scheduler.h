@@ -1,6 +1,10 @@
 #pragma once
 
+#include <atomic>
+
+#include "../idle_policy.h"
 #include "invocable_scheduler.h"
+#include "timed_object_scheduler.h"
 
 namespace mtbase
 {
@@ -13,9 +17,17 @@ namespace mtbase
         thread_local_scheduler(
             std::pmr::memory_resource* const res,
             object_flush_scheduler& objectFlushSched,
-            task_storage* const taskStorage) :
+            task_storage* const taskStorage,
+            task_storage* const groupStorage,
+            const size_t workerIndex,
+            const idle_policy&& idlePolicy,
+            const steady_tick timerResolution) :
             invocable_scheduler{ res, taskStorage },
-            flusher{ objectFlushSched }
+            flusher{ objectFlushSched },
+            groupTasks{ groupStorage },
+            timedSched{ timerResolution },
+            index{ workerIndex },
+            policy{ idlePolicy }
         {}
 
         virtual ~thread_local_scheduler()
@@ -24,22 +36,78 @@ namespace mtbase
     public:
         void flush();
 
+        [[nodiscard]]
+        static thread_local_scheduler* current()
+            noexcept;
+        [[nodiscard]]
+        object_flush_scheduler& getFlusher()
+            const noexcept;
+        [[nodiscard]]
+        timed_object_scheduler& getTimedScheduler()
+            noexcept;
+        [[nodiscard]]
+        size_t getWorkerIndex()
+            const noexcept;
+
+        [[nodiscard]]
+        bool pushRequestedTask(task_invoke_t* const task);
+        [[nodiscard]]
+        bool pushGroupTask(task_invoke_t* const task);
+        [[nodiscard]]
+        task_t* popGroupTask();
+        [[nodiscard]]
+        bool hasGroupTask()
+            const noexcept;
+        [[nodiscard]]
+        bool helpOnce();
+
+        [[nodiscard]]
+        task_t* exchangeNextTask(task_t* const task)
+            noexcept;
+        [[nodiscard]]
+        task_t* takeNextTask()
+            noexcept;
+        [[nodiscard]]
+        task_t* stealNextTask()
+            noexcept;
+
         virtual control_block& getControlBlock(const scheduler* const sched)
             noexcept = 0;
 
     protected:
-        void registerTaskImpl(task_invoke_t* const task)
+        bool registerTaskImpl(task_invoke_t* const task)
             override;
 
     private:
-        void flushRequested();
+        [[nodiscard]]
+        bool flushOnce(const size_t cntIdle);
+        [[nodiscard]]
+        bool flushRequested();
+        [[nodiscard]]
+        bool flushInjected();
+        void idle(size_t& cntIdle);
+        void park(size_t& cntIdle);
 
+        void executeTask(task_t* const task);
         void invokeTask(task_t* const task)
             const;
         void invokeTask(task_invoke_t* const task)
             const;
 
     private:
+        static constexpr size_t INJECTOR_POLL_INTERVAL = 31;
+        static constexpr size_t MAX_INJECTED_FLUSH_COUNT = 16;
+        static constexpr size_t MAX_NEXT_TASK_STREAK = 3;
+
+        static thread_local thread_local_scheduler* currentSched;
+
         object_flush_scheduler& flusher;
+        task_storage* const groupTasks;
+        timed_object_scheduler timedSched;
+        const size_t index;
+        const idle_policy policy;
+        size_t cntFlushOnce{ 0 };
+        std::atomic<task_t*> nextTask{ nullptr };
+        size_t cntNextTaskStreak{ 0 };
     };
 }
@@ -0,0 +1,38 @@
+#pragma once
+
+#include "../timer_wheel.h"
+
+namespace mtbase
+{
+    struct task_timed_invoke_t;
+
+    struct timed_object_scheduler final
+    {
+        timed_object_scheduler(const steady_tick tickResolution) :
+            wheel{ tickResolution, clock_t::getSteadyTick() }
+        {}
+
+    public:
+        void registerTimedTask(task_timed_invoke_t* const task)
+            noexcept;
+        void cancelTimedTask(task_timed_invoke_t* const task)
+            noexcept;
+        [[nodiscard]]
+        bool flush();
+
+        [[nodiscard]]
+        steady_tick getNextExpiry(const steady_tick tickLimit)
+            const noexcept;
+        [[nodiscard]]
+        bool isOwnerOf(const task_timed_invoke_t* const task)
+            const noexcept;
+
+    private:
+        void fireTask(
+            task_timed_invoke_t* const task,
+            const steady_tick tickNow);
+
+    private:
+        timer_wheel wheel;
+    };
+}
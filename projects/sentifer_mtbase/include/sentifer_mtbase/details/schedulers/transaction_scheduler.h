@@ -1,5 +1,7 @@
 #pragma once
 
+#include <span>
+
 #include "../scheduler.hpp"
 
 namespace mtbase
@@ -9,5 +11,28 @@ namespace mtbase
     struct transaction_scheduler final :
         public scheduler
     {
+        transaction_scheduler(std::pmr::memory_resource* const res) :
+            scheduler{ res, nullptr }
+        {}
+
+        virtual ~transaction_scheduler()
+        {}
+
+    public:
+        template<class Func, class... Args>
+        void registerTransaction(
+            std::span<object_scheduler* const> objectScheds,
+            Func&& func,
+            Args&&... args)
+        {
+            registerTransactionImpl(objectScheds, alloc.new_func_task(
+                std::forward<Func>(func),
+                std::make_tuple(std::forward<Args>(args)...)));
+        }
+
+    private:
+        void registerTransactionImpl(
+            std::span<object_scheduler* const> objectScheds,
+            task_invoke_t* const bodyTask);
     };
 }
@@ -2,6 +2,7 @@
 
 #include "memory_managers.hpp"
 #include "tasks.hpp"
+#include "futures.hpp"
 
 namespace mtbase
 {
@@ -16,7 +17,8 @@ namespace mtbase
         template<class Func, class TupleArgs>
         decltype(auto) new_func_task(Func&& func, TupleArgs&& args)
         {
-            return generic_allocator::new_object<task_func_t<Func, TupleArgs>>(
+            return new_task<
+                task_func_t<std::decay_t<Func>, std::decay_t<TupleArgs>>>(
                 std::forward<Func>(func), std::forward<TupleArgs>(args));
         }
 
@@ -24,18 +26,104 @@ namespace mtbase
         decltype(auto) new_method_task(
             T* const fromObj, Method&& method, TupleArgs&& args)
         {
-            return generic_allocator::new_object<task_method_t<T, Method, TupleArgs>>(
+            return new_task<
+                task_method_t<T, std::decay_t<Method>, std::decay_t<TupleArgs>>>(
                 fromObj, std::forward<Method>(method), std::forward<TupleArgs>(args));
         }
 
-        decltype(auto) new_flush_object_task(object_scheduler* const objectSched)
+        template<class Func, class TupleArgs>
+        decltype(auto) new_future_func_task(Func&& func, TupleArgs&& args)
+        {
+            return new_task<
+                task_future_func_t<std::decay_t<Func>, std::decay_t<TupleArgs>>>(
+                generic_allocator::resource(),
+                std::forward<Func>(func), std::forward<TupleArgs>(args));
+        }
+
+        template<class T, class Method, class TupleArgs>
+        decltype(auto) new_future_method_task(
+            T* const fromObj, Method&& method, TupleArgs&& args)
+        {
+            return new_future_func_task(std::forward<Method>(method),
+                std::tuple_cat(std::make_tuple(fromObj), std::forward<TupleArgs>(args)));
+        }
+
+        template<bool IS_TIMED, class T, class Method, class Reply, class TupleArgs>
+        decltype(auto) new_ask_task(
+            object_scheduler* const replySched,
+            T* const fromObj,
+            Method&& method,
+            Reply&& replied,
+            TupleArgs&& args)
+        {
+            return new_task<task_ask_t<IS_TIMED, T,
+                std::decay_t<Method>, std::decay_t<Reply>, std::decay_t<TupleArgs>>>(
+                generic_allocator::resource(), replySched, fromObj,
+                std::forward<Method>(method), std::forward<Reply>(replied),
+                std::forward<TupleArgs>(args));
+        }
+
+        template<class Func, class TupleArgs>
+        decltype(auto) new_read_task(
+            object_scheduler* const objectSched,
+            Func&& func,
+            TupleArgs&& args)
         {
-            return generic_allocator::new_object<task_flush_object_t>(objectSched);
+            return new_task<
+                task_read_t<std::decay_t<Func>, std::decay_t<TupleArgs>>>(
+                generic_allocator::resource(), objectSched,
+                std::forward<Func>(func), std::forward<TupleArgs>(args));
+        }
+
+        decltype(auto) new_flush_object_task(
+            object_scheduler* const objectSched,
+            const steady_tick deadline)
+        {
+            return new_task<task_flush_object_t>(objectSched, deadline);
+        }
+
+        decltype(auto) new_timed_invoke_task(
+            object_scheduler* const objectSched,
+            task_invoke_t* const targetTask,
+            const steady_tick at,
+            const steady_tick period)
+        {
+            return new_task<task_timed_invoke_t>(
+                generic_allocator::resource(), objectSched, targetTask, at, period);
+        }
+
+        decltype(auto) new_transaction_task(
+            std::span<object_scheduler* const> objectScheds,
+            task_invoke_t* const bodyTask)
+        {
+            return new_task<task_transaction_t>(
+                generic_allocator::resource(), objectScheds, bodyTask);
         }
 
         void delete_task(task_t* const task)
         {
-            generic_allocator::delete_object(task);
+            if (task->tryReleaseIntrusive())
+                return;
+
+            const size_t nbytes = task->allocatedSize;
+            const size_t alignment = task->allocatedAlign;
+
+            generic_allocator::destroy(task);
+            generic_allocator::deallocate_bytes(task, nbytes, alignment);
+        }
+
+    private:
+        template<class T, class... Args>
+        [[nodiscard]] T* new_task(Args&&... args)
+        {
+            static_assert(std::is_base_of_v<task_t, T>);
+            static_assert(sizeof(T) <= std::numeric_limits<uint32_t>::max());
+
+            T* const task = generic_allocator::new_object<T>(std::forward<Args>(args)...);
+            task->allocatedSize = sizeof(T);
+            task->allocatedAlign = alignof(T);
+
+            return task;
         }
     };
 }
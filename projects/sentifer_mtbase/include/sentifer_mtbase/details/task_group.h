@@ -0,0 +1,179 @@
+#pragma once
+
+#include <atomic>
+#include <exception>
+#include <memory_resource>
+#include <tuple>
+#include <type_traits>
+
+#include "memory_managers.hpp"
+#include "mtbase_assert.h"
+#include "tasks.hpp"
+#include "schedulers/thread_local_scheduler.h"
+
+namespace mtbase
+{
+    struct object_flush_scheduler;
+    struct task_group;
+
+    template<class Func, class TupleArgs>
+    struct task_group_func_t :
+        public task_invoke_t
+    {
+        template<class F, class T>
+        task_group_func_t(
+            std::pmr::memory_resource* const res,
+            task_group* const targetGroup,
+            F&& func,
+            T&& args) :
+            task_invoke_t{},
+            resource{ res },
+            group{ targetGroup },
+            invoked{ std::forward<F>(func) },
+            tupled{ std::forward<T>(args) }
+        {
+            static_assert(is_tuple_invocable_r_v<void, Func, TupleArgs>);
+        }
+
+        virtual ~task_group_func_t()
+        {}
+
+    public:
+        void invoke() override;
+
+        [[nodiscard]]
+        bool isReleasedOnInvoke()
+            const noexcept override
+        {
+            return true;
+        }
+
+    private:
+        std::pmr::memory_resource* const resource;
+        task_group* const group;
+        Func invoked;
+        TupleArgs tupled;
+    };
+
+    struct task_group final
+    {
+        task_group(
+            std::pmr::memory_resource* const res,
+            object_flush_scheduler& objectFlushSched) :
+            alloc{ res },
+            flusher{ objectFlushSched }
+        {}
+
+        task_group(const task_group&) = delete;
+
+        ~task_group()
+        {
+            MTBASE_ASSERT(isDone());
+        }
+
+        task_group& operator=(const task_group&) = delete;
+
+    public:
+        template<class Func, class... Args>
+        void spawn(Func&& func, Args&&... args)
+        {
+            using task_type = task_group_func_t<std::decay_t<Func>,
+                decltype(std::make_tuple(std::forward<Args>(args)...))>;
+
+            spawnImpl(alloc.new_object<task_type>(
+                alloc.resource(), this, std::forward<Func>(func),
+                std::make_tuple(std::forward<Args>(args)...)));
+        }
+
+        void wait();
+        [[nodiscard]]
+        bool isDone()
+            const noexcept;
+        [[nodiscard]]
+        std::pmr::memory_resource* getResource()
+            const noexcept;
+
+        void arrive(std::exception_ptr&& failure)
+            noexcept;
+
+    private:
+        void spawnImpl(task_invoke_t* const task);
+
+    private:
+        generic_allocator alloc;
+        object_flush_scheduler& flusher;
+        std::atomic_size_t cntPending{ 0 };
+        std::atomic_bool isFailed{ false };
+        std::exception_ptr exception{ nullptr };
+    };
+
+    template<class Func, class TupleArgs>
+    void task_group_func_t<Func, TupleArgs>::invoke()
+    {
+        task_group* const targetGroup = group;
+        std::exception_ptr failure{ nullptr };
+
+        try
+        {
+            std::apply(invoked, tupled);
+        }
+        catch (...)
+        {
+            failure = std::current_exception();
+        }
+
+        generic_allocator{ resource }.delete_object(this);
+        targetGroup->arrive(std::move(failure));
+    }
+
+    namespace details
+    {
+        template<class Index, class Func>
+        void parallel_for_range(
+            task_group& group,
+            Index begin,
+            Index end,
+            const Index grain,
+            Func& func)
+        {
+            while (begin < end)
+            {
+                if (end - begin > grain)
+                {
+                    const thread_local_scheduler* const threadSched =
+                        thread_local_scheduler::current();
+                    if (threadSched == nullptr || !threadSched->hasGroupTask())
+                    {
+                        const Index mid = begin + (end - begin) / 2;
+                        group.spawn([&group, &func, mid, end, grain]
+                            {
+                                parallel_for_range(group, mid, end, grain, func);
+                            });
+                        end = mid;
+
+                        continue;
+                    }
+                }
+
+                const Index chunkEnd = end - begin > grain ? begin + grain : end;
+                for (; begin < chunkEnd; ++begin)
+                    func(begin);
+            }
+        }
+    }
+
+    template<class Index, class Func>
+    void parallel_for(
+        task_group& group,
+        const Index begin,
+        const Index end,
+        const Index grain,
+        Func&& func)
+    {
+        static_assert(std::is_integral_v<Index>);
+        MTBASE_ASSERT(grain > 0);
+
+        details::parallel_for_range(group, begin, end, grain, func);
+        group.wait();
+    }
+}
@@ -1,7 +1,18 @@
 #pragma once
 
+#include <atomic>
+#include <coroutine>
+#include <memory_resource>
+#include <optional>
+#include <span>
+#include <tuple>
+#include <variant>
+#include <vector>
+
 #include "type_utils.hpp"
+#include "memory_managers.hpp"
 #include "clocks.hpp"
+#include "timer_handle.h"
 
 namespace mtbase
 {
@@ -9,6 +20,36 @@ namespace mtbase
     {
         virtual ~task_t()
         {}
+
+    public:
+        [[nodiscard]]
+        virtual bool tryReleaseIntrusive()
+            noexcept
+        {
+            return false;
+        }
+
+        [[nodiscard]]
+        virtual bool isReleasedOnInvoke()
+            const noexcept
+        {
+            return false;
+        }
+
+        [[nodiscard]]
+        virtual bool isReadOnly()
+            const noexcept
+        {
+            return false;
+        }
+
+    private:
+        friend struct task_allocator;
+
+        // Stamped by task_allocator so delete_task returns the concrete
+        // size and alignment to the pool instead of sizeof(task_t).
+        uint32_t allocatedSize{ sizeof(task_t) };
+        uint32_t allocatedAlign{ alignof(task_t) };
     };
 
     struct task_invoke_t :
@@ -25,10 +66,11 @@ namespace mtbase
     struct task_func_t :
         public task_invoke_t
     {
-        task_func_t(Func&& func, TupleArgs&& args) :
+        template<class F, class T>
+        task_func_t(F&& func, T&& args) :
             task_invoke_t{},
-            invoked{ func },
-            tupled{ args }
+            invoked{ std::forward<F>(func) },
+            tupled{ std::forward<T>(args) }
         {
             static_assert(is_tuple_invocable_r_v<void, Func, TupleArgs>);
         }
@@ -52,40 +94,371 @@ namespace mtbase
         public task_func_t<Method,
         tuple_extend_front_t<FromType* const, TupleArgs>>
     {
-        task_method_t(FromType* const fromObj, Method&& method, TupleArgs&& args) :
+        template<class M, class T>
+        task_method_t(FromType* const fromObj, M&& method, T&& args) :
             task_func_t<Method, tuple_extend_front_t<FromType* const, TupleArgs>>
             {
-                std::forward<Method>(method),
-                std::tuple_cat(std::make_tuple(fromObj), args)
+                std::forward<M>(method),
+                std::tuple_cat(std::make_tuple(fromObj), std::forward<T>(args))
             }
         {
             static_assert(std::is_member_function_pointer_v<Method>);
         }
     };
 
+    struct task_resume_t :
+        public task_invoke_t
+    {
+        virtual ~task_resume_t()
+        {}
+
+    public:
+        void invoke() override;
+        [[nodiscard]]
+        bool tryReleaseIntrusive()
+            noexcept override;
+        [[nodiscard]]
+        bool isReleasedOnInvoke()
+            const noexcept override;
+
+    public:
+        std::coroutine_handle<> handle{ nullptr };
+    };
+
     struct thread_local_scheduler;
     struct object_scheduler;
 
     struct task_flush_object_t :
         public task_t
     {
-        task_flush_object_t(object_scheduler* const sched) :
+        task_flush_object_t(
+            object_scheduler* const sched,
+            const steady_tick deadline) :
             task_t{},
-            objectSched{ sched }
+            objectSched{ sched },
+            tickDeadline{ deadline }
         {}
 
     public:
         void invoke(thread_local_scheduler& threadSched);
+        [[nodiscard]]
+        steady_tick getDeadline()
+            const noexcept;
 
     private:
         object_scheduler* const objectSched;
+        const steady_tick tickDeadline;
     };
 
+    struct timer_wheel;
+
     struct task_timed_invoke_t :
-        public task_t
+        public task_invoke_t
     {
-        const steady_tick tickExpiredAt{ steady_tick{} };
+        task_timed_invoke_t(
+            std::pmr::memory_resource* const res,
+            object_scheduler* const sched,
+            task_invoke_t* const target,
+            const steady_tick at,
+            const steady_tick period) :
+            task_invoke_t{},
+            tickExpiredAt{ at },
+            tickPeriod{ period },
+            targetTask{ target },
+            objectSched{ sched },
+            resource{ res }
+        {}
+
+        virtual ~task_timed_invoke_t()
+        {}
+
+    public:
+        void invoke() override;
+        [[nodiscard]]
+        bool tryReleaseIntrusive()
+            noexcept override;
+
+        void acquire()
+            noexcept;
+        void release()
+            noexcept;
+        [[nodiscard]]
+        bool cancel()
+            noexcept;
+        [[nodiscard]]
+        bool isCancelled()
+            const noexcept;
+        [[nodiscard]]
+        bool isPeriodic()
+            const noexcept;
+
+    public:
+        steady_tick tickExpiredAt{ steady_tick{} };
+        const steady_tick tickPeriod{ steady_tick{} };
         task_invoke_t* const targetTask{ nullptr };
+        object_scheduler* const objectSched{ nullptr };
+
+        task_timed_invoke_t* prev{ nullptr };
+        task_timed_invoke_t* next{ nullptr };
+        size_t level{ 0 };
+        size_t slot{ 0 };
+        bool isArmed{ false };
+        bool isTargetReleased{ false };
+        std::atomic<timer_wheel*> wheel{ nullptr };
+
+    private:
+        std::pmr::memory_resource* const resource;
+        std::atomic_size_t cntRef{ 1 };
+        std::atomic_bool cancelled{ false };
+    };
+
+    struct task_transaction_t :
+        public task_invoke_t
+    {
+        task_transaction_t(
+            std::pmr::memory_resource* const res,
+            std::span<object_scheduler* const> scheds,
+            task_invoke_t* const body);
+
+        virtual ~task_transaction_t()
+        {}
+
+    public:
+        void invoke() override;
+        [[nodiscard]]
+        bool tryReleaseIntrusive()
+            noexcept override;
+
+        void acquireNext();
+
+        [[nodiscard]]
+        object_scheduler* getFirstScheduler()
+            const noexcept;
+
+    private:
+        void resumeAcquired();
+        void acquire()
+            noexcept;
+        void release()
+            noexcept;
+
+    private:
+        std::pmr::vector<object_scheduler*> objectScheds;
+        task_invoke_t* const bodyTask;
+        size_t cntAcquired{ 0 };
+        std::pmr::memory_resource* const resource;
+        std::atomic_size_t cntRef{ 1 };
+    };
+
+    struct task_ask_base_t :
+        public task_invoke_t
+    {
+        task_ask_base_t(
+            std::pmr::memory_resource* const res,
+            object_scheduler* const sched) :
+            task_invoke_t{},
+            resource{ res },
+            timeoutTask{ *this },
+            replySched{ sched }
+        {}
+
+        virtual ~task_ask_base_t()
+        {}
+
+    public:
+        void invoke() override;
+        [[nodiscard]]
+        bool tryReleaseIntrusive()
+            noexcept override;
+
+        void armTimeout(const steady_tick at);
+
+    protected:
+        virtual void request() = 0;
+        virtual void reply() = 0;
+        virtual void timeout() = 0;
+        virtual void destroy()
+            noexcept = 0;
+
+    private:
+        struct task_timeout_t :
+            public task_invoke_t
+        {
+            task_timeout_t(task_ask_base_t& ownerTask) :
+                task_invoke_t{},
+                owner{ ownerTask }
+            {}
+
+        public:
+            void invoke() override;
+            [[nodiscard]]
+            bool tryReleaseIntrusive()
+                noexcept override;
+
+        private:
+            task_ask_base_t& owner;
+        };
+
+    private:
+        void acquire()
+            noexcept;
+        void release()
+            noexcept;
+
+    protected:
+        std::pmr::memory_resource* const resource;
+
+    private:
+        task_timeout_t timeoutTask;
+        object_scheduler* const replySched;
+        timer_handle timer;
+        bool isReplying{ false };
+        std::atomic_bool isSettled{ false };
+        std::atomic_size_t cntRef{ 1 };
+    };
+
+    template<bool IS_TIMED, class FromType, class Method, class Reply, class TupleArgs>
+    struct task_ask_t :
+        public task_ask_base_t
+    {
+    private:
+        using tupled_type = tuple_extend_front_t<FromType* const, TupleArgs>;
+        using result_type = decltype(std::apply(
+            std::declval<Method&>(), std::declval<tupled_type&>()));
+
+    public:
+        template<class M, class R, class T>
+        task_ask_t(
+            std::pmr::memory_resource* const res,
+            object_scheduler* const replySched,
+            FromType* const fromObj,
+            M&& method,
+            R&& replied,
+            T&& args) :
+            task_ask_base_t{ res, replySched },
+            invoked{ std::forward<M>(method) },
+            replyInvoked{ std::forward<R>(replied) },
+            tupled{ std::tuple_cat(std::make_tuple(fromObj), std::forward<T>(args)) }
+        {
+            static_assert(std::is_member_function_pointer_v<Method>);
+        }
+
+        virtual ~task_ask_t()
+        {}
+
+    protected:
+        void request() override
+        {
+            if constexpr (std::is_void_v<result_type>)
+                std::apply(invoked, tupled);
+            else
+                result.emplace(std::apply(invoked, tupled));
+        }
+
+        void reply() override
+        {
+            if constexpr (IS_TIMED && std::is_void_v<result_type>)
+                replyInvoked(true);
+            else if constexpr (IS_TIMED)
+                replyInvoked(std::optional<result_type>{ std::move(*result) });
+            else if constexpr (std::is_void_v<result_type>)
+                replyInvoked();
+            else
+                replyInvoked(std::move(*result));
+        }
+
+        void timeout() override
+        {
+            if constexpr (IS_TIMED && std::is_void_v<result_type>)
+                replyInvoked(false);
+            else if constexpr (IS_TIMED)
+                replyInvoked(std::optional<result_type>{});
+        }
+
+        void destroy()
+            noexcept override
+        {
+            generic_allocator{ resource }.delete_object(this);
+        }
+
+    private:
+        Method invoked;
+        Reply replyInvoked;
+        tupled_type tupled;
+        std::optional<std::conditional_t<std::is_void_v<result_type>,
+            std::monostate, result_type>> result;
+    };
+
+    struct task_read_base_t :
+        public task_invoke_t
+    {
+        task_read_base_t(
+            std::pmr::memory_resource* const res,
+            object_scheduler* const sched) :
+            task_invoke_t{},
+            resource{ res },
+            ownerSched{ sched }
+        {}
+
+        virtual ~task_read_base_t()
+        {}
+
+    public:
+        void invoke() override;
+        [[nodiscard]]
+        bool isReleasedOnInvoke()
+            const noexcept override;
+        [[nodiscard]]
+        bool isReadOnly()
+            const noexcept override;
+
+    protected:
+        virtual void read() = 0;
+        virtual void destroy()
+            noexcept = 0;
+
+    protected:
+        std::pmr::memory_resource* const resource;
+
+    private:
+        object_scheduler* const ownerSched;
+    };
+
+    template<class Func, class TupleArgs>
+    struct task_read_t :
+        public task_read_base_t
+    {
+        template<class F, class T>
+        task_read_t(
+            std::pmr::memory_resource* const res,
+            object_scheduler* const sched,
+            F&& func,
+            T&& args) :
+            task_read_base_t{ res, sched },
+            invoked{ std::forward<F>(func) },
+            tupled{ std::forward<T>(args) }
+        {
+            static_assert(is_tuple_invocable_r_v<void, Func, TupleArgs>);
+        }
+
+        virtual ~task_read_t()
+        {}
+
+    protected:
+        void read() override
+        {
+            std::apply(invoked, tupled);
+        }
+
+        void destroy()
+            noexcept override
+        {
+            generic_allocator{ resource }.delete_object(this);
+        }
+
+    private:
+        Func invoked;
+        TupleArgs tupled;
     };
 
     struct timed_object_scheduler;
@@ -99,7 +472,7 @@ namespace mtbase
         {}
 
     public:
-        void invoke(thread_local_scheduler& threadSched);
+        void invoke();
 
     private:
         timed_object_scheduler* const timedObjectSched;
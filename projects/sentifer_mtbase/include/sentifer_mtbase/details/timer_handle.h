@@ -0,0 +1,32 @@
+#pragma once
+
+namespace mtbase
+{
+    struct task_timed_invoke_t;
+
+    struct timer_handle
+    {
+        timer_handle() noexcept = default;
+        explicit timer_handle(task_timed_invoke_t* const task) noexcept;
+        timer_handle(const timer_handle&) = delete;
+        timer_handle(timer_handle&& other) noexcept;
+
+        ~timer_handle();
+
+        timer_handle& operator=(const timer_handle&) = delete;
+        timer_handle& operator=(timer_handle&& other) noexcept;
+
+    public:
+        bool cancel()
+            noexcept;
+        void reset()
+            noexcept;
+
+        [[nodiscard]]
+        explicit operator bool()
+            const noexcept;
+
+    private:
+        task_timed_invoke_t* timedTask{ nullptr };
+    };
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+#include "clocks.hpp"
+
+namespace mtbase
+{
+    struct task_timed_invoke_t;
+
+    struct timer_wheel
+    {
+        timer_wheel(
+            const steady_tick tickResolution,
+            const steady_tick tickNow) :
+            resolution{ tickResolution },
+            tickCurrent{ toWheelTick(tickNow) }
+        {
+            for (auto& x : slots)
+                x.fill(nullptr);
+        }
+
+        ~timer_wheel();
+
+    public:
+        void insert(task_timed_invoke_t* const task)
+            noexcept;
+        void erase(task_timed_invoke_t* const task)
+            noexcept;
+        [[nodiscard]]
+        task_timed_invoke_t* advance(const steady_tick tickNow)
+            noexcept;
+
+        [[nodiscard]]
+        steady_tick getNextExpiry(const steady_tick tickLimit)
+            const noexcept;
+        [[nodiscard]]
+        size_t size()
+            const noexcept;
+
+    private:
+        void link(
+            task_timed_invoke_t* const task,
+            const uint64_t tickSlot)
+            noexcept;
+        void cascade(const size_t level)
+            noexcept;
+        void collect(task_timed_invoke_t*& expired)
+            noexcept;
+
+        [[nodiscard]]
+        uint64_t toWheelTick(const steady_tick tick)
+            const noexcept;
+        [[nodiscard]]
+        uint64_t toWheelTickCeil(const steady_tick tick)
+            const noexcept;
+
+    private:
+        static constexpr size_t SLOT_BITS = 6;
+        static constexpr size_t SLOT_COUNT = 1 << SLOT_BITS;
+        static constexpr size_t LEVEL_COUNT = 4;
+        static constexpr uint64_t MAX_DELTA =
+            (uint64_t{ 1 } << (SLOT_BITS * LEVEL_COUNT)) - 1;
+
+        const steady_tick resolution;
+        uint64_t tickCurrent;
+        size_t cnt{ 0 };
+        std::array<uint64_t, LEVEL_COUNT> occupied{};
+        std::array<std::array<task_timed_invoke_t*, SLOT_COUNT>, LEVEL_COUNT> slots;
+    };
+}
@@ -1,9 +1,17 @@
 #pragma once
 
 #include "details/memory_managers.hpp"
+#include "details/batch_handler.hpp"
 #include "details/clocks.hpp"
+#include "details/coroutines.hpp"
+#include "details/futures.hpp"
+#include "details/parallel_algorithms.hpp"
+#include "details/task_group.h"
+#include "details/timer_handle.h"
 #include "details/schedulers/thread_local_scheduler.h"
 #include "details/schedulers/transaction_scheduler.h"
+#include "details/schedulers/timed_object_scheduler.h"
 #include "details/schedulers/object_scheduler.h"
 #include "details/schedulers/object_flush_scheduler.h"
 #include "details/schedulables/schedulable_object.hpp"
+#include "details/schedulables/schedulable_actor.hpp"
@@ -1,506 +1,716 @@
 #include "../include/sentifer_mtbase/details/base_structures.hpp"
 
-using namespace mtbase;
+#include <algorithm>
+#include <limits>
+#include <vector>
 
-#pragma region task_storage__descriptor
+using namespace mtbase;
 
-[[nodiscard]]
-task_storage::descriptor task_storage::descriptor::copied(
-    const index_t& oldIndexLoad,
-    const index_t& newIndexLoad,
-    task_t* const oldTaskLoad)
-    const noexcept
+namespace
 {
-    return descriptor
+    enum HAZARD :
+        size_t
     {
-        .phase = phase,
-        .op = op,
-        .oldTask = oldTaskLoad,
-        .newTask = newTask,
-        .oldIndex = oldIndexLoad,
-        .newIndex = newIndexLoad
+        HAZARD_INDEX,
+        HAZARD_DESC,
+        HAZARD_HELP,
+        HAZARD_BASE,
+        HAZARD_ATTEMPT,
+        HAZARD_REQUEST,
+        HAZARD_COUNT
     };
-}
 
-[[nodiscard]]
-task_storage::descriptor task_storage::descriptor::rollbacked(
-    const index_t& oldIndexLoad,
-    const index_t& newIndexLoad,
-    task_t* const oldTaskLoad)
-    const noexcept
-{
-    return descriptor
+    std::atomic_size_t cntHazardRecords{ 0 };
+
+    [[nodiscard]]
+    bool isMarker(task_t* const value)
+        noexcept
     {
-        .phase = descriptor::PHASE::RESERVE,
-        .op = op,
-        .oldTask = oldTaskLoad,
-        .newTask = newTask,
-        .oldIndex = oldIndexLoad,
-        .newIndex = newIndexLoad
-    };
-}
+        return (reinterpret_cast<uintptr_t>(value) & 1) != 0;
+    }
 
-[[nodiscard]]
-task_storage::descriptor task_storage::descriptor::completed()
-    const noexcept
-{
-    return descriptor
+    template<class PHASE>
+    [[nodiscard]]
+    bool isUndecided(const PHASE phase)
+        noexcept
     {
-        .phase = descriptor::PHASE::COMPLETE,
-        .op = op,
-        .oldTask = oldTask
-    };
+        return phase == PHASE::RESERVE || phase == PHASE::CLAIMED;
+    }
+
+    template<class T>
+    [[nodiscard]]
+    bool tryAcquire(T* const node)
+        noexcept
+    {
+        size_t cntLoad = node->cntRef.load();
+        while (cntLoad != 0)
+        {
+            if (node->cntRef.compare_exchange_weak(cntLoad, cntLoad + 1))
+                return true;
+        }
+
+        return false;
+    }
 }
 
-[[nodiscard]]
-task_storage::descriptor task_storage::descriptor::failed()
-    const noexcept
+#pragma region task_storage__hazard_record
+
+// Hazard pointers shared by every task_storage. A thread publishes a node
+// before reading through it, and a retired node is freed only once no
+// record publishes it. Records outlive their threads and are reused.
+struct alignas(BASE_ALIGN * 8) task_storage::hazard_record
 {
-    return descriptor
+    template<class T>
+    [[nodiscard]]
+    T* protect(const HAZARD slot, const std::atomic<T*>& src)
+        noexcept
     {
-        .phase = descriptor::PHASE::FAIL,
-        .op = op,
-        .oldTask = oldTask
-    };
-}
+        T* p = src.load();
 
-#pragma endregion task_storage__descriptor
+        while (true)
+        {
+            hazards[slot].store(p);
 
-template<class T>
-bool tryEfficientCAS(
-    std::atomic<T>& target,
-    T& expected,
-    T const desired)
-    noexcept
+            T* const reloaded = src.load();
+            if (reloaded == p)
+                return p;
+
+            p = reloaded;
+        }
+    }
+
+    void publish(const HAZARD slot, const void* const p)
+        noexcept
+    {
+        hazards[slot].store(p);
+    }
+
+    void clear()
+        noexcept
+    {
+        for (auto& hazard : hazards)
+            hazard.store(nullptr, std::memory_order_release);
+    }
+
+public:
+    std::array<std::atomic<const void*>, HAZARD_COUNT> hazards{};
+    std::atomic_bool isActive{ true };
+    hazard_record* next{ nullptr };
+};
+
+#pragma endregion task_storage__hazard_record
+
+#pragma region task_storage
+
+task_storage::task_storage(std::pmr::memory_resource* res) :
+    alloc{ res }
 {
-    return target.compare_exchange_strong(expected, desired,
-        std::memory_order_acq_rel, std::memory_order_acquire);
+    descriptor* const init = alloc.new_object<descriptor>(
+        descriptor::PHASE::COMPLETE, OP::NONE, nullptr, nullptr,
+        nullptr, nullptr, index_t{}, index_t{}, size_t{ 1 });
+    index.store(init, std::memory_order_relaxed);
 }
 
-#pragma region task_storage
+task_storage::~task_storage()
+{
+    deleteDesc(index.load(std::memory_order_relaxed));
+    reclaimAll();
+}
 
 [[nodiscard]]
 bool task_storage::push_front(task_t* const task)
 {
-    descriptor* const desc = createDesc(task, OP::PUSH_FRONT);
-
-    if (desc == nullptr)
+    task_t* popped = nullptr;
+    if (!applyDesc(OP::PUSH_FRONT, task, popped))
         return false;
 
-    bool result = (desc->phase == descriptor::PHASE::COMPLETE);
-    destroyDesc(desc);
-
-    if (result)
-        cnt.fetch_add(1);
+    cnt.fetch_add(1);
 
-    return result;
+    return true;
 }
 
 [[nodiscard]]
 bool task_storage::push_back(task_t* const task)
 {
-    descriptor* const desc = createDesc(task, OP::PUSH_BACK);
-
-    if (desc == nullptr)
+    task_t* popped = nullptr;
+    if (!applyDesc(OP::PUSH_BACK, task, popped))
         return false;
 
-    bool result = (desc->phase == descriptor::PHASE::COMPLETE);
-    destroyDesc(desc);
+    cnt.fetch_add(1);
 
-    if (result)
-        cnt.fetch_add(1);
-
-    return result;
+    return true;
 }
 
 [[nodiscard]]
 task_t* task_storage::pop_front()
 {
-    descriptor* const desc = createDesc(nullptr, OP::POP_FRONT);
-
-    if (desc == nullptr)
+    task_t* popped = nullptr;
+    if (!applyDesc(OP::POP_FRONT, nullptr, popped))
         return nullptr;
 
-    task_t* result = (desc->phase == descriptor::PHASE::COMPLETE ?
-        desc->oldTask : nullptr);
-    destroyDesc(desc);
-
-    if (result != nullptr)
-        cnt.fetch_sub(1);
+    cnt.fetch_sub(1);
 
-    return result;
+    return popped;
 }
 
 [[nodiscard]]
 task_t* task_storage::pop_back()
 {
-    descriptor* const desc = createDesc(nullptr, OP::POP_BACK);
-
-    if (desc == nullptr)
+    task_t* popped = nullptr;
+    if (!applyDesc(OP::POP_BACK, nullptr, popped))
         return nullptr;
 
-    task_t* result = (desc->phase == descriptor::PHASE::COMPLETE ?
-        desc->oldTask : nullptr);
-    destroyDesc(desc);
+    cnt.fetch_sub(1);
 
-    if (result != nullptr)
-        cnt.fetch_sub(1);
+    return popped;
+}
 
-    return result;
+[[nodiscard]]
+size_t task_storage::size()
+    const noexcept
+{
+    const size_t cntLoad = cnt.load(std::memory_order_relaxed);
+
+    constexpr size_t MAX_VALID_COUNT =
+        static_cast<size_t>(std::numeric_limits<std::ptrdiff_t>::max());
+
+    return cntLoad > MAX_VALID_COUNT ? 0 : cntLoad;
 }
 
 [[nodiscard]]
-task_storage::descriptor* task_storage::createDesc(task_t* const task, OP op)
+bool task_storage::applyDesc(const OP op, task_t* const task, task_t*& popped)
 {
-    index_t oldIndex = *(index.load(std::memory_order_acquire));
+    hazard_record& hp = localHazardRecord();
+
+    helpRegistered(hp);
+
+    RESULT result = RESULT::RETRY;
+    for (size_t i = 0; i < MAX_RETRY && result == RESULT::RETRY; ++i)
+        result = fast_path(hp, op, task, nullptr, popped);
+
+    if (result == RESULT::RETRY)
+        result = slow_path(hp, op, task, popped);
+
+    hp.clear();
+    reclaim();
+
+    return result == RESULT::COMPLETE;
+}
+
+[[nodiscard]]
+task_storage::RESULT task_storage::fast_path(
+    hazard_record& hp,
+    const OP op,
+    task_t* const task,
+    request* const owner,
+    task_t*& popped)
+{
+    descriptor* const base = hp.protect(HAZARD_INDEX, index);
+    const index_t oldIndex = base->newIndex;
     if (!isValidIndex(oldIndex, op))
-        return nullptr;
+        return RESULT::INVALID;
 
-    index_t newIndex = moveIndex(oldIndex, op);
     std::atomic<task_t*>& target = getElementRef(oldIndex, op);
-
-    descriptor descVal
+    task_t* oldTask = target.load();
+    if (isMarker(oldTask))
     {
-        .phase = descriptor::PHASE::RESERVE,
-        .op = op,
-        .oldTask = target.load(std::memory_order_acquire),
-        .newTask = task,
-        .oldIndex = oldIndex,
-        .newIndex = newIndex
-    };
-    descriptor* desc = new_desc(descVal);
-    
-    do
+        helpMarker(hp, target, oldTask);
+
+        return RESULT::RETRY;
+    }
+
+    // A push slot holding a task, or a pop slot holding none, means the
+    // index has moved on since it was read.
+    const bool isPush = (op == OP::PUSH_FRONT || op == OP::PUSH_BACK);
+    if (isPush != (oldTask == nullptr))
+        return RESULT::RETRY;
+
+    // A request that lost its last reference has already finished.
+    if (owner != nullptr && !tryAcquire(owner))
+        return RESULT::RETRY;
+
+    descriptor* const desc = alloc.new_object<descriptor>(
+        descriptor::PHASE::RESERVE, op, oldTask, isPush ? task : nullptr,
+        base, owner, oldIndex, moveIndex(oldIndex, op));
+    hp.publish(HAZARD_DESC, desc);
+
+    task_t* const marker = reinterpret_cast<task_t*>(
+        reinterpret_cast<uintptr_t>(desc) | 1);
+    if (!target.compare_exchange_strong(oldTask, marker))
     {
-        descriptor* helpDesc = nullptr;
-        tryRegister(helpDesc, nullptr);
-        helpRegistered(helpDesc);
-        destroyDesc(helpDesc);
-    } while (!trySetProgress(op));
+        deleteDesc(desc);
 
-    applyDesc(desc);
-    
-    releaseProgress(op);
+        return RESULT::RETRY;
+    }
 
-    return desc;
-}
+    helpDesc(hp, desc);
 
-void task_storage::destroyDesc(descriptor* const desc)
-{
-    if (desc == nullptr)
-        return;
+    if (desc->phase.load() != descriptor::PHASE::COMPLETE)
+        return RESULT::RETRY;
 
-    descriptor* oldDesc = desc;
-    tryRegister(oldDesc, nullptr);
+    popped = desc->oldTask;
 
-    delete_desc(desc);
+    return RESULT::COMPLETE;
 }
 
 [[nodiscard]]
-task_storage::index_t* task_storage::new_index(const index_t& idx)
+task_storage::RESULT task_storage::slow_path(
+    hazard_record& hp,
+    const OP op,
+    task_t* const task,
+    task_t*& popped)
 {
-    return alloc.new_object<index_t>(idx);
-}
+    request* const req = alloc.new_object<request>(op, task);
 
-void task_storage::delete_index(index_t* const idx)
-{
-    if (idx != nullptr)
-        alloc.delete_object(idx);
-}
+    while (true)
+    {
+        request* const cur = hp.protect(HAZARD_REQUEST, registered);
+        if (cur != nullptr)
+        {
+            helpRequest(hp, cur);
+            unregister(cur);
 
-[[nodiscard]]
-task_storage::descriptor* task_storage::new_desc(const descriptor& desc)
-{
-    return alloc.new_object<descriptor>(desc);
-}
+            continue;
+        }
 
-[[nodiscard]]
-task_storage::descriptor* task_storage::copy_desc(descriptor* const desc)
-{
-    if (desc == nullptr)
-        return nullptr;
+        req->cntRef.fetch_add(1);
+
+        request* expected = nullptr;
+        if (registered.compare_exchange_strong(expected, req))
+            break;
+
+        releaseRequest(req);
+    }
+
+    hp.publish(HAZARD_REQUEST, nullptr);
+
+    helpRequest(hp, req);
+    unregister(req);
+
+    descriptor* const last = req->attempt.exchange(finishedAttempt());
+    const bool isApplied = (last != finishedAttempt() && last != nullptr &&
+        last->phase.load() == descriptor::PHASE::COMPLETE);
+
+    if (isApplied)
+        popped = last->oldTask;
 
-    descriptor copied =
-        desc->copied(desc->oldIndex, desc->newIndex,
-        getElementRef(desc->oldIndex, desc->op));
+    if (last != finishedAttempt() && last != nullptr)
+        releaseDesc(last);
 
-    return new_desc(copied);
+    releaseRequest(req);
+
+    return isApplied ? RESULT::COMPLETE : RESULT::INVALID;
 }
 
-void task_storage::delete_desc(descriptor* const desc)
+void task_storage::helpRegistered(hazard_record& hp)
 {
-    if (desc != nullptr)
-        alloc.delete_object(desc);
+    request* const req = hp.protect(HAZARD_REQUEST, registered);
+    if (req == nullptr)
+        return;
+
+    helpRequest(hp, req);
+    unregister(req);
+
+    hp.publish(HAZARD_REQUEST, nullptr);
 }
 
-void task_storage::applyDesc(descriptor*& desc)
+void task_storage::helpRequest(hazard_record& hp, request* const req)
 {
-    for (size_t i = 0; i < MAX_RETRY; ++i)
-        if (fast_path(desc))
+    while (true)
+    {
+        descriptor* const cur = hp.protect(HAZARD_HELP, req->attempt);
+        if (cur == finishedAttempt())
             return;
 
-    slow_path(desc);
+        if (cur != nullptr)
+        {
+            const descriptor::PHASE phase = cur->phase.load();
+            if (phase == descriptor::PHASE::COMPLETE)
+                return;
+
+            if (isUndecided(phase))
+            {
+                helpDesc(hp, cur);
+
+                continue;
+            }
+        }
+
+        // No attempt yet, or the last one failed: run the next one. The
+        // request is refused only if no attempt of it has committed.
+        task_t* popped = nullptr;
+        if (fast_path(hp, req->op, req->task, req, popped) != RESULT::INVALID)
+            continue;
+
+        descriptor* expected = cur;
+        if (req->attempt.compare_exchange_strong(expected, finishedAttempt()) &&
+            cur != nullptr)
+            releaseDesc(cur);
+    }
 }
 
-bool task_storage::fast_path(descriptor*& desc)
+void task_storage::helpMarker(
+    hazard_record& hp,
+    std::atomic<task_t*>& target,
+    task_t* const marker)
 {
-    if (!tryCommit(desc))
-        return false;
+    descriptor* const desc = reinterpret_cast<descriptor*>(
+        reinterpret_cast<uintptr_t>(marker) & ~uintptr_t{ 1 });
 
-    if (desc->phase == descriptor::PHASE::RESERVE)
-        completeDesc(desc);
+    // The marker holds a reference, so desc is alive while it is in place.
+    // HAZARD_HELP may still guard the attempt of a request being helped.
+    hp.publish(HAZARD_DESC, desc);
+    if (target.load() == marker)
+        helpDesc(hp, desc);
 
-    return true;
+    hp.publish(HAZARD_DESC, nullptr);
 }
 
-void task_storage::slow_path(descriptor*& desc)
+void task_storage::helpDesc(hazard_record& hp, descriptor* const desc)
 {
-    while (true)
+    if (isUndecided(desc->phase.load()))
+        tryCommitIndex(hp, desc);
+
+    finalizeDesc(desc);
+}
+
+void task_storage::tryCommitIndex(hazard_record& hp, descriptor* const desc)
+{
+    descriptor* const base = desc->base;
+
+    // The thread that created desc publishes base until desc is decided,
+    // so base is still alive if desc is undecided after this publish.
+    hp.publish(HAZARD_BASE, base);
+    if (!isUndecided(desc->phase.load()))
     {
-        descriptor* oldDesc = nullptr;
-        if (tryRegister(oldDesc, desc))
-            break;
+        hp.publish(HAZARD_BASE, nullptr);
 
-        helpRegistered(oldDesc);
+        return;
     }
 
-    while (desc != nullptr &&
-        desc->phase == descriptor::PHASE::RESERVE)
+    // Only the attempt a request has claimed may commit, so a request
+    // helped by several threads still applies once. A helper that lost the
+    // claim may fail the attempt concurrently, so it commits only after
+    // moving it to CLAIMED, which that failure can no longer undo.
+    if (desc->owner != nullptr)
     {
-        descriptor* tmp = copy_desc(desc);
+        if (!tryClaim(hp, desc->owner, desc))
+            tryFailUnclaimedDesc(desc);
+        else
+        {
+            descriptor::PHASE expected = descriptor::PHASE::RESERVE;
+            desc->phase.compare_exchange_strong(expected, descriptor::PHASE::CLAIMED);
+        }
 
-        helpRegistered(tmp);
-        if (tmp != nullptr)
+        if (desc->phase.load() != descriptor::PHASE::CLAIMED)
         {
-            destroyDesc(desc);
-            desc = tmp;
+            hp.publish(HAZARD_BASE, nullptr);
 
             return;
         }
-
-        descriptor* oldDesc = refreshIndex(desc);
-        renewRegistered(oldDesc, desc);
     }
-}
 
-void task_storage::helpRegistered(descriptor*& desc)
-{
-    while (desc != nullptr &&
-        desc->phase == descriptor::PHASE::RESERVE &&
-        !tryCommitWithRegistered(desc));
+    // base was the index when desc was made, so it has committed. Marking
+    // it before replacing it lets its helpers tell a replaced commit from
+    // a failure.
+    base->phase.store(descriptor::PHASE::COMPLETE);
 
-    while (desc != nullptr &&
-        desc->phase == descriptor::PHASE::RESERVE)
+    descriptor* expected = base;
+    if (index.compare_exchange_strong(expected, desc))
     {
-        descriptor* oldDesc = desc;
-        descriptor completed = desc->completed();
-        desc = new_desc(completed);
-        renewRegistered(oldDesc, desc);
+        completeDesc(desc);
+        releaseDesc(base);
     }
+    else if (expected == desc)
+        completeDesc(desc);
+    else
+    {
+        // The index left base and never returns to it, so desc can only
+        // have committed if someone replaced it, which marked it first.
+        tryFailDesc(desc);
+    }
+
+    hp.publish(HAZARD_BASE, nullptr);
 }
 
 [[nodiscard]]
-bool task_storage::tryCommit(descriptor*& desc)
+bool task_storage::tryClaim(
+    hazard_record& hp,
+    request* const req,
+    descriptor* const desc)
 {
-    if (!tryCommitTask(desc))
+    while (true)
     {
-        descriptor* oldDesc = refreshIndex(desc);
-        destroyDesc(oldDesc);
+        descriptor* const cur = hp.protect(HAZARD_ATTEMPT, req->attempt);
+        if (cur == desc)
+            return true;
 
-        return false;
-    }
+        if (cur == finishedAttempt())
+            return false;
 
-    if (!tryCommitIndex(desc))
-    {
-        descriptor* oldDesc = rollbackTask(desc);
-        destroyDesc(oldDesc);
+        if (cur != nullptr &&
+            cur->phase.load() != descriptor::PHASE::FAIL)
+            return false;
 
-        return false;
-    }
+        if (!tryAcquire(desc))
+            return false;
 
-    return true;
-}
+        descriptor* expected = cur;
+        if (req->attempt.compare_exchange_strong(expected, desc))
+        {
+            if (cur != nullptr)
+                releaseDesc(cur);
 
-[[nodiscard]]
-bool task_storage::tryCommitWithRegistered(descriptor*& desc)
-{
-    if (!tryCommitTask(desc))
-    {
-        descriptor* oldDesc = refreshIndex(desc);
-        renewRegistered(oldDesc, desc);
+            return true;
+        }
 
-        return false;
+        releaseDesc(desc);
     }
+}
+
+void task_storage::completeDesc(descriptor* const desc)
+    noexcept
+{
+    descriptor::PHASE expected = desc->phase.load();
+    while (isUndecided(expected) &&
+        !desc->phase.compare_exchange_weak(expected, descriptor::PHASE::COMPLETE));
+}
 
-    if (!tryCommitIndex(desc))
+void task_storage::tryFailDesc(descriptor* const desc)
+{
+    descriptor::PHASE expected = desc->phase.load();
+    while (isUndecided(expected))
     {
-        descriptor* oldDesc = rollbackTask(desc);
-        renewRegistered(oldDesc, desc);
+        if (desc->phase.compare_exchange_weak(expected, descriptor::PHASE::FAIL))
+        {
+            releaseDesc(desc);
 
-        return false;
+            return;
+        }
     }
-
-    return true;
 }
 
-[[nodiscard]]
-task_storage::descriptor* task_storage::rollbackTask(descriptor*& desc)
+void task_storage::tryFailUnclaimedDesc(descriptor* const desc)
 {
-    std::atomic<task_t*>& target = getElementRef(desc->oldIndex, desc->op);
-    target.store(desc->oldTask, std::memory_order_release);
-
-    return refreshIndex(desc);
+    descriptor::PHASE expected = descriptor::PHASE::RESERVE;
+    if (desc->phase.compare_exchange_strong(expected, descriptor::PHASE::FAIL))
+        releaseDesc(desc);
 }
 
-[[nodiscard]]
-task_storage::descriptor* task_storage::refreshIndex(descriptor*& desc)
+void task_storage::finalizeDesc(descriptor* const desc)
 {
-    descriptor* oldDesc = desc;
-    index_t oldIndex = *(index.load(std::memory_order_acquire));
-    if (isValidIndex(oldIndex, oldDesc->op))
-    {
-        index_t newIndex = moveIndex(oldIndex, oldDesc->op);
-        descriptor rollbacked =
-            oldDesc->rollbacked(oldIndex, newIndex,
-            getElementRef(oldIndex, oldDesc->op));
-        desc = new_desc(rollbacked);
-    }
-    else
-    {
-        descriptor failed = oldDesc->failed();
-        desc = new_desc(failed);
-    }
+    const descriptor::PHASE phase = desc->phase.load();
+    if (isUndecided(phase))
+        return;
+
+    std::atomic<task_t*>& target = getElementRef(desc->oldIndex, desc->op);
+    task_t* expected = reinterpret_cast<task_t*>(
+        reinterpret_cast<uintptr_t>(desc) | 1);
+    task_t* const desired = (phase == descriptor::PHASE::COMPLETE ?
+        desc->newTask : desc->oldTask);
 
-    return oldDesc;
+    if (target.compare_exchange_strong(expected, desired))
+        releaseDesc(desc);
 }
 
-void task_storage::completeDesc(descriptor*& desc)
+void task_storage::unregister(request* const req)
 {
-    descriptor completed = desc->completed();
-    alloc.destroy(desc);
-    alloc.construct(desc, completed);
+    request* expected = req;
+    if (registered.compare_exchange_strong(expected, nullptr))
+        releaseRequest(req);
 }
 
-void task_storage::renewRegistered(
-    descriptor* const oldDesc,
-    descriptor*& desc)
+void task_storage::releaseDesc(descriptor* const desc)
 {
-    descriptor* curDesc = oldDesc;
-    if (tryRegister(curDesc, desc))
-        destroyDesc(oldDesc);
-    else
-    {
-        destroyDesc(oldDesc);
-        destroyDesc(desc);
-
-        desc = copy_desc(curDesc);
-    }
+    if (desc->cntRef.fetch_sub(1) == 1)
+        retireDesc(desc);
 }
 
-[[nodiscard]]
-bool task_storage::trySetProgress(const OP op)
-noexcept
+void task_storage::releaseRequest(request* const req)
 {
-    std::atomic_bool& target = getTargetProgress(op);
-    bool oldTarget = false;
-
-    return tryEfficientCAS(target, oldTarget, true);
+    if (req->cntRef.fetch_sub(1) == 1)
+        retireRequest(req);
 }
 
-void task_storage::releaseProgress(const OP op)
-noexcept
+void task_storage::deleteDesc(descriptor* const desc)
 {
-    getTargetProgress(op)
-        .store(false, std::memory_order_release);
+    request* const owner = desc->owner;
+    alloc.delete_object(desc);
+
+    if (owner != nullptr)
+        releaseRequest(owner);
 }
 
-[[nodiscard]]
-std::atomic_bool& task_storage::getTargetProgress(const OP op)
+void task_storage::retireDesc(descriptor* const desc)
     noexcept
 {
-    switch (op)
+    descriptor* head = retiredDescs.load();
+    do
     {
-    case OP::PUSH_FRONT:
-    case OP::POP_FRONT:
-        return progressFront;
-    case OP::PUSH_BACK:
-    case OP::POP_BACK:
-    default:
-        return progressBack;
-    }
+        desc->retiredNext = head;
+    } while (!retiredDescs.compare_exchange_weak(head, desc));
+
+    cntRetired.fetch_add(1);
 }
 
-[[nodiscard]]
-bool task_storage::tryCommitTask(descriptor* const desc)
+void task_storage::retireRequest(request* const req)
     noexcept
 {
-    task_t* oldTask = desc->oldTask;
-    std::atomic<task_t*>& target = getElementRef(desc->oldIndex, desc->op);
+    request* head = retiredRequests.load();
+    do
+    {
+        req->retiredNext = head;
+    } while (!retiredRequests.compare_exchange_weak(head, req));
 
-    return tryEfficientCAS(target, oldTask, desc->newTask);
+    cntRetired.fetch_add(1);
 }
 
-[[nodiscard]]
-bool task_storage::tryCommitIndex(descriptor* const desc)
-    noexcept
+void task_storage::reclaim()
 {
-    index_t* origin = index.load(std::memory_order_acquire);
-    index_t originCopied = *origin;
-    if (originCopied != desc->oldIndex)
-        return false;
+    const size_t cntHazards = cntHazardRecords.load(std::memory_order_relaxed) * HAZARD_COUNT;
 
-    index_t* newIndex = new_index(desc->newIndex);
+    // Freeing in batches larger than the published set keeps the scan
+    // amortized to a constant per retired node.
+    if (cntRetired.load(std::memory_order_relaxed) < RECLAIM_BATCH + cntHazards * 2)
+        return;
+
+    descriptor* descs = retiredDescs.exchange(nullptr);
+    request* reqs = retiredRequests.exchange(nullptr);
+
+    std::pmr::vector<const void*> published{ alloc.resource() };
+    published.reserve(cntHazards);
+    for (hazard_record* record = hazardRecords().load(); record != nullptr; record = record->next)
+    {
+        for (auto& hazard : record->hazards)
+        {
+            if (const void* const p = hazard.load(); p != nullptr)
+                published.push_back(p);
+        }
+    }
+    std::sort(published.begin(), published.end());
 
-    if (tryEfficientCAS(index, origin, newIndex))
+    const auto isPublished = [&published](const void* const p)
     {
-        delete_index(origin);
+        return std::binary_search(published.begin(), published.end(), p);
+    };
 
-        return true;
+    while (descs != nullptr)
+    {
+        descriptor* const next = descs->retiredNext;
+        cntRetired.fetch_sub(1);
+
+        if (isPublished(descs))
+            retireDesc(descs);
+        else
+            deleteDesc(descs);
+
+        descs = next;
     }
 
-    delete_index(newIndex);
+    while (reqs != nullptr)
+    {
+        request* const next = reqs->retiredNext;
+        cntRetired.fetch_sub(1);
 
-    return false;
+        if (isPublished(reqs))
+            retireRequest(reqs);
+        else
+            alloc.delete_object(reqs);
+
+        reqs = next;
+    }
 }
 
-bool task_storage::tryRegister(
-    descriptor*& expected,
-    descriptor* const desired)
-    noexcept
+void task_storage::reclaimAll()
 {
-    descriptor* origin = registered.load(std::memory_order_acquire);
-    descriptor* originCopied = copy_desc(origin);
-
-    if (origin == nullptr && expected != nullptr)
+    while (true)
     {
-        expected = nullptr;
+        descriptor* descs = retiredDescs.exchange(nullptr);
+        request* reqs = retiredRequests.exchange(nullptr);
+        if (descs == nullptr && reqs == nullptr)
+            return;
 
-        delete_desc(originCopied);
+        while (descs != nullptr)
+        {
+            descriptor* const next = descs->retiredNext;
+            deleteDesc(descs);
+            descs = next;
+        }
 
-        return false;
+        while (reqs != nullptr)
+        {
+            request* const next = reqs->retiredNext;
+            alloc.delete_object(reqs);
+            reqs = next;
+        }
     }
+}
 
-    if (origin != nullptr &&
-        (expected == nullptr || *expected != *originCopied))
+[[nodiscard]]
+task_storage::hazard_record& task_storage::localHazardRecord()
+{
+    struct record_owner
     {
-        expected = originCopied;
+        record_owner()
+        {
+            std::atomic<hazard_record*>& records = hazardRecords();
+
+            for (hazard_record* r = records.load(); r != nullptr; r = r->next)
+            {
+                bool isActive = false;
+                if (r->isActive.compare_exchange_strong(isActive, true))
+                {
+                    record = r;
+
+                    return;
+                }
+            }
+
+            // Records are never freed; threads that exit hand theirs on.
+            record = generic_allocator{ std::pmr::new_delete_resource() }
+                .new_object<hazard_record>();
+
+            hazard_record* head = records.load();
+            do
+            {
+                record->next = head;
+            } while (!records.compare_exchange_weak(head, record));
+
+            cntHazardRecords.fetch_add(1);
+        }
 
-        return false;
-    }
+        ~record_owner()
+        {
+            record->clear();
+            record->isActive.store(false, std::memory_order_release);
+        }
 
-    delete_desc(originCopied);
+    public:
+        hazard_record* record{ nullptr };
+    };
 
-    descriptor* const copied = copy_desc(desired);
-    if (tryEfficientCAS(registered, origin, copied))
-    {
-        delete_desc(origin);
+    thread_local record_owner owner;
 
-        return true;
-    }
+    return *owner.record;
+}
 
-    delete_desc(copied);
+[[nodiscard]]
+std::atomic<task_storage::hazard_record*>& task_storage::hazardRecords()
+    noexcept
+{
+    static std::atomic<hazard_record*> records{ nullptr };
+
+    return records;
+}
+
+[[nodiscard]]
+task_storage::descriptor* task_storage::finishedAttempt()
+    noexcept
+{
+    // Parks a finished request so no further attempt can claim it.
+    static descriptor finished{ descriptor::PHASE::COMPLETE };
 
-    return false;
+    return &finished;
 }
 
 #pragma endregion task_storage
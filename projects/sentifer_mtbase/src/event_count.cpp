@@ -0,0 +1,113 @@
+#include "../include/sentifer_mtbase/details/event_count.h"
+
+#include <algorithm>
+
+using namespace mtbase;
+
+[[nodiscard]]
+size_t event_count::prepareWait()
+    noexcept
+{
+    cntWaiters.fetch_add(1, std::memory_order_seq_cst);
+
+    return epoch.load(std::memory_order_seq_cst);
+}
+
+void event_count::cancelWait()
+    noexcept
+{
+    cntWaiters.fetch_sub(1, std::memory_order_seq_cst);
+}
+
+void event_count::wait(
+    const size_t key,
+    const steady_tick tickParkUntil)
+{
+    const std::chrono::steady_clock::time_point parkUntil{
+        std::chrono::duration_cast<std::chrono::steady_clock::duration>(tickParkUntil) };
+
+    bool isNotified = false;
+
+    cntParked.fetch_add(1, std::memory_order_relaxed);
+
+    {
+        std::unique_lock<std::mutex> lock{ mtx };
+
+        while (epoch.load(std::memory_order_acquire) == key)
+        {
+            if (cv.wait_until(lock, parkUntil) == std::cv_status::timeout)
+                break;
+
+            isNotified = true;
+        }
+    }
+
+    cancelWait();
+
+    if (isNotified && epoch.load(std::memory_order_acquire) != key)
+        recordWakeUp(clock_t::getSteadyTick());
+}
+
+void event_count::notifyOne()
+{
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    if (cntWaiters.load(std::memory_order_seq_cst) == 0)
+        return;
+
+    tickNotified.store(clock_t::getSteadyTick().count(), std::memory_order_relaxed);
+
+    {
+        std::lock_guard<std::mutex> lock{ mtx };
+        epoch.fetch_add(1, std::memory_order_release);
+    }
+
+    cv.notify_one();
+}
+
+void event_count::notifyAll()
+{
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    if (cntWaiters.load(std::memory_order_seq_cst) == 0)
+        return;
+
+    tickNotified.store(clock_t::getSteadyTick().count(), std::memory_order_relaxed);
+
+    {
+        std::lock_guard<std::mutex> lock{ mtx };
+        epoch.fetch_add(1, std::memory_order_release);
+    }
+
+    cv.notify_all();
+}
+
+[[nodiscard]]
+idle_statistics event_count::getStatistics()
+    const noexcept
+{
+    return idle_statistics
+    {
+        .cntParked = cntParked.load(std::memory_order_relaxed),
+        .cntWokenUp = cntWokenUp.load(std::memory_order_relaxed),
+        .tickWakeUpLatencyTotal = steady_tick{
+            tickLatencyTotal.load(std::memory_order_relaxed) },
+        .tickWakeUpLatencyMax = steady_tick{
+            tickLatencyMax.load(std::memory_order_relaxed) }
+    };
+}
+
+void event_count::recordWakeUp(const steady_tick tickWokenUp)
+    noexcept
+{
+    const steady_tick::rep latency = std::max<steady_tick::rep>(0,
+        tickWokenUp.count() - tickNotified.load(std::memory_order_relaxed));
+
+    cntWokenUp.fetch_add(1, std::memory_order_relaxed);
+    tickLatencyTotal.fetch_add(latency, std::memory_order_relaxed);
+
+    steady_tick::rep oldMax = tickLatencyMax.load(std::memory_order_relaxed);
+    while (oldMax < latency &&
+        !tickLatencyMax.compare_exchange_weak(oldMax, latency,
+            std::memory_order_relaxed, std::memory_order_relaxed));
+}
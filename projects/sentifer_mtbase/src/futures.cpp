@@ -0,0 +1,11 @@
+#include "../include/sentifer_mtbase/details/futures.hpp"
+
+#include "../include/sentifer_mtbase/details/schedulers/object_scheduler.h"
+
+using namespace mtbase;
+
+void details::future_dispatcher::dispatch(task_invoke_t* const task)
+    const
+{
+    targetSched->registerFutureTask(task);
+}
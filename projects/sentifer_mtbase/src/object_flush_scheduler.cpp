@@ -1,57 +1,612 @@
 #include "../include/sentifer_mtbase/details/schedulers/object_flush_scheduler.h"
 
+#include <algorithm>
+
 #include "../include/sentifer_mtbase/details/base_structures.hpp"
 #include "../include/sentifer_mtbase/details/control_block.h"
+#include "../include/sentifer_mtbase/details/schedulers/object_scheduler.h"
 #include "../include/sentifer_mtbase/details/schedulers/thread_local_scheduler.h"
 
 using namespace mtbase;
 
+object_flush_scheduler::~object_flush_scheduler()
+{
+    // Tasks still queued when the pool goes away are dropped, not run.
+    for (task_t* const task : injectedTasks)
+        alloc.delete_task(task);
+
+    for (task_t* const task : spilledTasks)
+        alloc.delete_task(task);
+}
+
+void object_flush_scheduler::injectTask(task_invoke_t* const task)
+{
+    {
+        std::lock_guard<std::mutex> lock{ injectorMutex };
+
+        injectedTasks.push_back(task);
+        cntInjected.fetch_add(1, std::memory_order_release);
+    }
+
+    wakeWorker();
+}
+
+[[nodiscard]]
+task_t* object_flush_scheduler::popInjectedTask()
+{
+    if (!hasInjectedTask())
+        return nullptr;
+
+    std::lock_guard<std::mutex> lock{ injectorMutex };
+
+    if (injectedTasks.empty())
+        return nullptr;
+
+    task_t* const task = injectedTasks.front();
+    injectedTasks.pop_front();
+    cntInjected.fetch_sub(1, std::memory_order_release);
+
+    return task;
+}
+
+[[nodiscard]]
+bool object_flush_scheduler::hasInjectedTask()
+    const noexcept
+{
+    return cntInjected.load(std::memory_order_acquire) > 0;
+}
+
 void object_flush_scheduler::registerFlushObjectTask(object_scheduler* const objectSched)
 {
-    registerTaskImpl(alloc.new_flush_object_task(objectSched));
+    registerTaskImpl(
+        alloc.new_flush_object_task(objectSched, makeDeadline(0)),
+        objectSched->getLastWorkerIndex());
+}
+
+void object_flush_scheduler::registerYieldedFlushObjectTask(object_scheduler* const objectSched)
+{
+    task_flush_object_t* const task =
+        alloc.new_flush_object_task(objectSched, makeDeadline(0));
+
+    // Requeued on this worker's shard to keep the object's state core-local,
+    // unless shared work is waiting: the shard is popped first, so the
+    // object would run again ahead of the work it yielded to.
+    task_storage* const localShard = getLocalShard();
+    if (localShard != nullptr && !hasSharedTask() &&
+        localShard->size() <= MAX_AFFINITY_BACKLOG &&
+        localShard->push_back(task))
+    {
+        wakeWorker();
+
+        return;
+    }
+
+    pushSharedTask(task);
+
+    wakeWorker();
+}
+
+void object_flush_scheduler::registerNextFlushObjectTask(object_scheduler* const objectSched)
+{
+    thread_local_scheduler* const threadSched = thread_local_scheduler::current();
+    if (threadSched == nullptr || &threadSched->getFlusher() != this)
+    {
+        registerFlushObjectTask(objectSched);
+
+        return;
+    }
+
+    // An object whose state is warm on another worker goes back to that
+    // worker, unless its shard is backed up enough to migrate it anyway.
+    const size_t lastWorkerIndex = objectSched->getLastWorkerIndex();
+    const task_storage* const preferredShard = getPreferredShard(lastWorkerIndex);
+    if (preferredShard != nullptr && preferredShard != getLocalShard() &&
+        preferredShard->size() <= MAX_AFFINITY_BACKLOG)
+    {
+        registerTaskImpl(
+            alloc.new_flush_object_task(objectSched, makeDeadline(0)),
+            lastWorkerIndex);
+
+        return;
+    }
+
+    task_t* const displacedTask = threadSched->exchangeNextTask(
+        alloc.new_flush_object_task(objectSched, makeDeadline(0)));
+    if (displacedTask != nullptr)
+        registerTaskImpl(
+            static_cast<task_flush_object_t*>(displacedTask),
+            threadSched->getWorkerIndex());
+}
+
+void object_flush_scheduler::registerFlushObjectTask(
+    object_scheduler* const objectSched,
+    const steady_tick tickPendingSince)
+{
+    const size_t level = getDeadlineLevel(tickPendingSince);
+    if (level == 0)
+    {
+        registerFlushObjectTask(objectSched);
+
+        return;
+    }
+
+    task_flush_object_t* const task =
+        alloc.new_flush_object_task(objectSched, makeDeadline(level));
+    if (deadlineBuckets[level - 1]->push_back(task))
+    {
+        wakeWorker();
+
+        return;
+    }
+
+    registerTaskImpl(task, objectSched->getLastWorkerIndex());
 }
 
-void object_flush_scheduler::flush(thread_local_scheduler& threadSched)
+[[nodiscard]]
+bool object_flush_scheduler::flush(
+    thread_local_scheduler& threadSched,
+    const bool isStarving)
 {
     control_block& block = threadSched.getControlBlock(this);
 
-    flushTasks(block);
+    block.reset();
+
+    const bool isFlushed = flushTasks(threadSched, block, isStarving);
 
     block.release();
 
-    threadSched.registerMethodTask(
-        this, &object_flush_scheduler::flush, threadSched);
+    return isFlushed;
+}
+
+void object_flush_scheduler::attachWorker(thread_local_scheduler& threadSched)
+    noexcept
+{
+    if (workers.empty())
+        return;
+
+    workers[getShardIndex(threadSched)].store(&threadSched, std::memory_order_release);
+}
+
+void object_flush_scheduler::detachWorker(thread_local_scheduler& threadSched)
+    noexcept
+{
+    if (workers.empty())
+        return;
+
+    thread_local_scheduler* expected = &threadSched;
+    workers[getShardIndex(threadSched)].compare_exchange_strong(
+        expected, nullptr, std::memory_order_acq_rel);
 }
 
-void object_flush_scheduler::registerTaskImpl(task_flush_object_t* const task)
+void object_flush_scheduler::registerReadTask(task_invoke_t* const task)
 {
-    if (!storage->push_back(task))
+    const thread_local_scheduler* const threadSched = thread_local_scheduler::current();
+    if (threadSched == nullptr || &threadSched->getFlusher() != this || workers.empty())
     {
-        alloc.delete_task(task);
+        injectTask(task);
+
+        return;
+    }
+
+    // Reads of one flush are spread over the workers' own queues, which
+    // only their owners drain, so task_group helpers never pick them up.
+    const size_t workerIndex =
+        idxNextWorker.fetch_add(1, std::memory_order_relaxed) % workers.size();
+    thread_local_scheduler* const target =
+        workers[workerIndex].load(std::memory_order_acquire);
+    if (target == nullptr || !target->pushRequestedTask(task))
+    {
+        injectTask(task);
+
+        return;
     }
+
+    // The target may be parked; waking just one worker could miss it.
+    if (target != threadSched)
+        idleEvent.notifyAll();
 }
 
-void object_flush_scheduler::flushTasks(control_block& block)
+[[nodiscard]]
+bool object_flush_scheduler::tryRegisterGroupTask(task_invoke_t* const task)
 {
+    thread_local_scheduler* target = thread_local_scheduler::current();
+    if (target == nullptr || &target->getFlusher() != this)
+    {
+        if (workers.empty())
+            return false;
+
+        const size_t workerIndex =
+            idxNextWorker.fetch_add(1, std::memory_order_relaxed) % workers.size();
+        target = workers[workerIndex].load(std::memory_order_acquire);
+        if (target == nullptr)
+            return false;
+    }
+
+    if (!target->pushGroupTask(task))
+        return false;
+
+    wakeWorker();
+
+    return true;
+}
+
+[[nodiscard]]
+task_t* object_flush_scheduler::stealGroupTask(
+    const thread_local_scheduler& threadSched)
+{
+    const size_t shardIndex = getShardIndex(threadSched);
+    for (size_t i = 1; i < workers.size(); ++i)
+    {
+        thread_local_scheduler* const victim =
+            workers[(shardIndex + i) % workers.size()].load(std::memory_order_acquire);
+        if (victim == nullptr || victim == &threadSched || !victim->hasGroupTask())
+            continue;
+
+        task_t* const task = victim->popGroupTask();
+        if (task != nullptr)
+            return task;
+    }
+
+    return nullptr;
+}
+
+void object_flush_scheduler::wakeWorker()
+{
+    idleEvent.notifyOne();
+}
+
+void object_flush_scheduler::requestStop()
+{
+    isStopping.store(true, std::memory_order_seq_cst);
+
+    // Parked workers only look at the flag once they wake up.
+    idleEvent.notifyAll();
+}
+
+[[nodiscard]]
+bool object_flush_scheduler::isStopRequested()
+    const noexcept
+{
+    return isStopping.load(std::memory_order_seq_cst);
+}
+
+[[nodiscard]]
+event_count& object_flush_scheduler::getIdleEvent()
+    noexcept
+{
+    return idleEvent;
+}
+
+[[nodiscard]]
+idle_statistics object_flush_scheduler::getIdleStatistics()
+    const noexcept
+{
+    return idleEvent.getStatistics();
+}
+
+void object_flush_scheduler::recordAffinity(const bool isHit)
+    noexcept
+{
+    if (isHit)
+        cntAffinityHit.fetch_add(1, std::memory_order_relaxed);
+    else
+        cntAffinityMigrated.fetch_add(1, std::memory_order_relaxed);
+}
+
+[[nodiscard]]
+affinity_statistics object_flush_scheduler::getAffinityStatistics()
+    const noexcept
+{
+    return affinity_statistics{
+        .cntHit = cntAffinityHit.load(std::memory_order_relaxed),
+        .cntMigrated = cntAffinityMigrated.load(std::memory_order_relaxed) };
+}
+
+[[nodiscard]]
+size_t object_flush_scheduler::getBacklogPerWorker()
+    const noexcept
+{
+    size_t cntBacklog = storage->size();
+    for (task_storage* const shard : shards)
+        cntBacklog += shard->size();
+    for (task_storage* const bucket : deadlineBuckets)
+        cntBacklog += bucket->size();
+    cntBacklog += cntSpilled.load(std::memory_order_relaxed);
+
+    return shards.empty() ? cntBacklog : cntBacklog / shards.size();
+}
+
+void object_flush_scheduler::registerTaskImpl(
+    task_flush_object_t* const task,
+    const size_t preferredWorkerIndex)
+{
+    task_storage* const localShard = getLocalShard();
+    task_storage* const preferredShard = getPreferredShard(preferredWorkerIndex);
+    task_storage* const targetShard = preferredShard != nullptr ?
+        preferredShard : localShard;
+    if (targetShard != nullptr &&
+        targetShard->size() <= MAX_AFFINITY_BACKLOG &&
+        targetShard->push_back(task))
+    {
+        wakeWorker();
+
+        return;
+    }
+
+    pushSharedTask(task);
+
+    wakeWorker();
+}
+
+[[nodiscard]]
+bool object_flush_scheduler::hasSharedTask()
+    const noexcept
+{
+    return storage->size() > 0 ||
+        cntSpilled.load(std::memory_order_acquire) != 0;
+}
+
+void object_flush_scheduler::pushSharedTask(task_flush_object_t* const task)
+{
+    if (cntSpilled.load(std::memory_order_acquire) != 0 ||
+        !storage->push_back(task))
+        spillTask(task);
+}
+
+void object_flush_scheduler::spillTask(task_flush_object_t* const task)
+{
+    std::lock_guard<std::mutex> lock{ spillMutex };
+
+    spilledTasks.push_back(task);
+    cntSpilled.fetch_add(1, std::memory_order_release);
+}
+
+[[nodiscard]]
+task_t* object_flush_scheduler::popSpilledTask()
+{
+    if (cntSpilled.load(std::memory_order_acquire) == 0)
+        return nullptr;
+
+    std::lock_guard<std::mutex> lock{ spillMutex };
+
+    if (spilledTasks.empty())
+        return nullptr;
+
+    task_t* const task = spilledTasks.front();
+    spilledTasks.pop_front();
+    cntSpilled.fetch_sub(1, std::memory_order_release);
+
+    return task;
+}
+
+[[nodiscard]]
+bool object_flush_scheduler::flushTasks(
+    thread_local_scheduler& threadSched,
+    control_block& block,
+    const bool isStarving)
+{
+    bool isFlushed = false;
+
     for (size_t i = 0;
         i < restriction.MAX_FLUSH_COUNT_AT_ONCE &&
         !block.checkExpiredCount(restriction);
         ++i)
-        executeTask(block);
+        isFlushed |= executeTask(threadSched, block, isStarving);
+
+    return isFlushed;
 }
 
-void object_flush_scheduler::executeTask(control_block& block)
+[[nodiscard]]
+bool object_flush_scheduler::executeTask(
+    thread_local_scheduler& threadSched,
+    control_block& block,
+    const bool isStarving)
 {
-    task_t* const task = storage->pop_front();
+    task_t* const task = popTask(threadSched, isStarving);
     if (task == nullptr)
     {
         block.recordCountExpired(restriction);
 
-        return;
+        return false;
     }
 
-    invokeTask(block, task);
+    invokeTask(block, static_cast<task_flush_object_t*>(task));
     alloc.delete_task(task);
+
+    return true;
+}
+
+[[nodiscard]]
+task_t* object_flush_scheduler::popTask(
+    thread_local_scheduler& threadSched,
+    const bool isStarving)
+{
+    size_t bucketIndex = 0;
+    task_t* const lateTask = popLateTask(bucketIndex);
+    task_t* const task = popQueuedTask(threadSched, isStarving);
+    if (lateTask == nullptr)
+        return task;
+    if (task == nullptr)
+        return lateTask;
+
+    // Earliest deadline first; the other task goes back to the head of
+    // the queue it is compared from on the next pop.
+    if (getDeadline(task) < getDeadline(lateTask) &&
+        deadlineBuckets[bucketIndex]->push_front(lateTask))
+        return task;
+
+    const size_t shardIndex = getShardIndex(threadSched);
+    if (shardIndex >= shards.size() ||
+        !shards[shardIndex]->push_front(task))
+        registerTaskImpl(
+            static_cast<task_flush_object_t*>(task),
+            threadSched.getWorkerIndex());
+
+    return lateTask;
+}
+
+[[nodiscard]]
+task_t* object_flush_scheduler::popQueuedTask(
+    thread_local_scheduler& threadSched,
+    const bool isStarving)
+{
+    task_t* const nextTask = threadSched.takeNextTask();
+    if (nextTask != nullptr)
+        return nextTask;
+
+    const size_t shardIndex = getShardIndex(threadSched);
+
+    if (shardIndex < shards.size())
+    {
+        task_t* const task = shards[shardIndex]->pop_front();
+        if (task != nullptr)
+            return task;
+    }
+
+    if (storage->size() > 0)
+    {
+        task_t* const task = storage->pop_front();
+        if (task != nullptr)
+            return task;
+    }
+
+    task_t* const spilledTask = popSpilledTask();
+    if (spilledTask != nullptr)
+        return spilledTask;
+
+    return stealTask(shardIndex, isStarving);
+}
+
+[[nodiscard]]
+task_t* object_flush_scheduler::popLateTask(size_t& bucketIndex)
+{
+    for (size_t i = deadlineBuckets.size(); i > 0; --i)
+    {
+        if (deadlineBuckets[i - 1]->size() == 0)
+            continue;
+
+        task_t* const task = deadlineBuckets[i - 1]->pop_front();
+        if (task != nullptr)
+        {
+            bucketIndex = i - 1;
+
+            return task;
+        }
+    }
+
+    return nullptr;
+}
+
+[[nodiscard]]
+task_t* object_flush_scheduler::stealTask(
+    const size_t shardIndex,
+    const bool isStarving)
+{
+    for (size_t i = 1; i <= shards.size(); ++i)
+    {
+        const size_t victimIndex = (shardIndex + i) % shards.size();
+        if (victimIndex == shardIndex)
+            continue;
+
+        if (!isStarving && shards[victimIndex]->size() <= MAX_AFFINITY_BACKLOG)
+            continue;
+
+        task_t* const task = shards[victimIndex]->pop_front();
+        if (task != nullptr)
+            return task;
+    }
+
+    if (!isStarving)
+        return nullptr;
+
+    for (size_t i = 1; i < workers.size(); ++i)
+    {
+        thread_local_scheduler* const victim =
+            workers[(shardIndex + i) % workers.size()].load(std::memory_order_acquire);
+        if (victim == nullptr)
+            continue;
+
+        task_t* const task = victim->stealNextTask();
+        if (task != nullptr)
+            return task;
+    }
+
+    return nullptr;
+}
+
+[[nodiscard]]
+task_storage* object_flush_scheduler::getLocalShard()
+    const noexcept
+{
+    const thread_local_scheduler* const threadSched =
+        thread_local_scheduler::current();
+    if (threadSched == nullptr || &threadSched->getFlusher() != this)
+        return nullptr;
+
+    const size_t shardIndex = getShardIndex(*threadSched);
+
+    return shardIndex < shards.size() ? shards[shardIndex] : nullptr;
+}
+
+[[nodiscard]]
+task_storage* object_flush_scheduler::getPreferredShard(
+    const size_t preferredWorkerIndex)
+    const noexcept
+{
+    if (preferredWorkerIndex == object_scheduler::NO_WORKER_INDEX ||
+        shards.empty())
+        return nullptr;
+
+    return shards[preferredWorkerIndex % shards.size()];
+}
+
+[[nodiscard]]
+size_t object_flush_scheduler::getDeadlineLevel(
+    const steady_tick tickPendingSince)
+    const noexcept
+{
+    if (deadlineBuckets.empty() || DEADLINE_BUCKET_TICK <= steady_tick{})
+        return 0;
+
+    const steady_tick tickWaited = clock_t::getSteadyTick() - tickPendingSince;
+    if (tickWaited < DEADLINE_BUCKET_TICK)
+        return 0;
+
+    return std::min(
+        static_cast<size_t>(tickWaited / DEADLINE_BUCKET_TICK),
+        deadlineBuckets.size());
+}
+
+[[nodiscard]]
+steady_tick object_flush_scheduler::makeDeadline(const size_t level)
+    const noexcept
+{
+    const steady_tick tickNow = clock_t::getSteadyTick();
+    if (deadlineBuckets.empty() || DEADLINE_BUCKET_TICK <= steady_tick{})
+        return tickNow;
+
+    // A late object is due as soon as a fresh one enqueued `level` buckets
+    // earlier, so lateness moves it forward by a bounded amount only.
+    return tickNow +
+        DEADLINE_BUCKET_TICK * static_cast<int64_t>(deadlineBuckets.size() - level);
+}
+
+[[nodiscard]]
+steady_tick object_flush_scheduler::getDeadline(const task_t* const task)
+    noexcept
+{
+    return static_cast<const task_flush_object_t*>(task)->getDeadline();
+}
+
+[[nodiscard]]
+size_t object_flush_scheduler::getShardIndex(
+    const thread_local_scheduler& threadSched)
+    const noexcept
+{
+    if (shards.empty())
+        return 0;
+
+    return threadSched.getWorkerIndex() % shards.size();
 }
 
 void object_flush_scheduler::invokeTask(
@@ -1,82 +1,1260 @@
 #include "../include/sentifer_mtbase/details/schedulers/object_scheduler.h"
 
+#include <algorithm>
+#include <functional>
+#include <thread>
+#include <utility>
+#include <immintrin.h>
+
 #include "../include/sentifer_mtbase/details/base_structures.hpp"
 #include "../include/sentifer_mtbase/details/control_block.h"
+#include "../include/sentifer_mtbase/details/mtbase_assert.h"
 #include "../include/sentifer_mtbase/details/schedulers/thread_local_scheduler.h"
 #include "../include/sentifer_mtbase/details/schedulers/object_flush_scheduler.h"
+#include "../include/sentifer_mtbase/details/schedulers/timed_object_scheduler.h"
 
 using namespace mtbase;
 
+object_scheduler::~object_scheduler()
+{
+    for (priority_lane& lane : lanes)
+    {
+        for (task_t* const task : lane.overflowTasks)
+            alloc.delete_task(task);
+
+        if (lane.deleter == nullptr)
+            continue;
+
+        for (task_t* task = lane.storage->pop_front(); task != nullptr;
+            task = lane.storage->pop_front())
+            alloc.delete_task(task);
+
+        lane.deleter(lanes.get_allocator().resource(), lane.storage);
+    }
+
+    for (const auto& [key, task] : coalescedTasks)
+        alloc.delete_task(task);
+
+    for (size_t i = idxOwnedTask; i < ownedTasks.size(); ++i)
+        alloc.delete_task(ownedTasks[i]);
+
+    for (size_t i = idxSubmittedTask; i < submittedTasks.size(); ++i)
+        alloc.delete_task(submittedTasks[i]);
+
+    discardSubmits();
+
+    if (blockedTask != nullptr)
+        alloc.delete_task(blockedTask);
+}
+
+[[nodiscard]]
+size_t object_scheduler::addPriorityLaneImpl(
+    task_storage* const laneStorage,
+    const size_t weight,
+    const lane_storage_deleter deleter)
+{
+    MTBASE_ASSERT(weight > 0);
+
+    try
+    {
+        lanes.emplace_back(lanes.get_allocator().resource(), laneStorage, weight, deleter);
+    }
+    catch (...)
+    {
+        deleter(lanes.get_allocator().resource(), laneStorage);
+
+        throw;
+    }
+
+    return lanes.size() - 1;
+}
+
+void object_scheduler::setOverflowPolicy(const overflow_policy policy)
+    noexcept
+{
+    overflowPolicy = policy;
+}
+
+void object_scheduler::registerResumeTask(task_resume_t* const task)
+{
+    registerInternalTaskImpl(task);
+}
+
+void object_scheduler::registerFutureTask(task_invoke_t* const task)
+{
+    registerInternalTaskImpl(task);
+}
+
+void object_scheduler::registerAskTask(task_ask_base_t* const task)
+{
+    registerInternalTaskImpl(task);
+}
+
+void object_scheduler::registerMailboxTask(task_invoke_t* const task)
+{
+    registerInternalTaskImpl(task);
+}
+
+void object_scheduler::registerBatchTask(task_invoke_t* const task)
+{
+    registerInternalTaskImpl(task);
+}
+
+[[nodiscard]]
+timer_handle object_scheduler::registerAskTimeoutTask(
+    const steady_tick at,
+    task_invoke_t* const task)
+{
+    return registerTimedTaskImpl(task, at, steady_tick{});
+}
+
+void object_scheduler::registerResumeTaskAt(
+    const steady_tick at,
+    task_resume_t* const task,
+    timer_handle& handle)
+{
+    registerTimedTaskImpl(task, at, steady_tick{}, handle);
+}
+
+void object_scheduler::registerExpiredTask(task_timed_invoke_t* const task)
+{
+    registerInternalTaskImpl(task);
+}
+
+void object_scheduler::registerTransactionTask(task_transaction_t* const task)
+{
+    const bool isCuttingIn = task->getFirstScheduler() != this;
+
+    pushTask(
+        isCuttingIn ? lanes.back() : lanes.front(),
+        task, isCuttingIn, overflow_policy::SPILL);
+}
+
+thread_local object_scheduler* object_scheduler::currentSched{ nullptr };
+thread_local size_t object_scheduler::cntDispatchDepth{ 0 };
+thread_local object_scheduler::submit_queue_owner object_scheduler::localSubmitQueue;
+
+object_scheduler::submit_queue_owner::~submit_queue_owner()
+{
+    if (queue == nullptr)
+        return;
+
+    {
+        submit_registry& registry = getSubmitRegistry();
+        std::lock_guard lock{ registry.mutex };
+
+        std::erase(registry.queues, queue);
+    }
+
+    // Other threads seal entries only under the registry lock, so every
+    // entry is either free or still ours to commit.
+    commitQueue(*queue);
+
+    generic_allocator{ std::pmr::new_delete_resource() }.delete_object(queue);
+}
+
 void object_scheduler::flush(thread_local_scheduler& threadSched)
 {
     if (!tryOwn())
         return;
 
+    const size_t workerIndex = threadSched.getWorkerIndex();
+    const size_t prevWorkerIndex =
+        lastWorkerIndex.exchange(workerIndex, std::memory_order_relaxed);
+    if (prevWorkerIndex != NO_WORKER_INDEX)
+        flusher.recordAffinity(prevWorkerIndex == workerIndex);
+
     threadSched.getControlBlock(this).reset();
+    beginBacklog();
 
     flushOwned(threadSched);
 }
 
-void object_scheduler::registerTaskImpl(task_invoke_t* const task)
+bool object_scheduler::registerTaskImpl(task_invoke_t* const task)
+{
+    if (currentSched == this && runningBlock != nullptr)
+    {
+        if (ownedTasks.size() - idxOwnedTask < MAX_OWNED_TASK_COUNT &&
+            lanes.front().cntOverflow.load(std::memory_order_acquire) == 0)
+        {
+            ownedTasks.push_back(task);
+
+            return true;
+        }
+
+        // Owned tasks run after the lanes, so move them ahead of this one
+        // before it meets the overflow policy like any other task.
+        spillOwnedTasks();
+    }
+
+    return pushTask(lanes.front(), task, false, overflowPolicy);
+}
+
+bool object_scheduler::registerTaskCuttingInImpl(task_invoke_t* const task)
+{
+    return pushTask(lanes.back(), task, true, overflowPolicy);
+}
+
+bool object_scheduler::registerTaskOnLaneImpl(
+    const size_t lane,
+    task_invoke_t* const task)
+{
+    MTBASE_ASSERT(lane < lanes.size());
+
+    return pushTask(lanes[lane], task, false, overflowPolicy);
+}
+
+void object_scheduler::registerInternalTaskImpl(task_invoke_t* const task)
+{
+    pushTask(lanes.front(), task, false, overflow_policy::SPILL);
+}
+
+bool object_scheduler::registerCoalescedTaskImpl(
+    const size_t key,
+    task_invoke_t* const task)
 {
-    if (!storage->push_back(task))
+    task_invoke_t* replacedTask = nullptr;
+
+    {
+        std::lock_guard lock{ coalesceMutex };
+
+        const auto [entry, isInserted] = coalescedTasks.try_emplace(key, task);
+        if (!isInserted)
+            replacedTask = std::exchange(entry->second, task);
+    }
+
+    if (replacedTask != nullptr)
+    {
+        alloc.delete_task(replacedTask);
+
+        return true;
+    }
+
+    registerInternalTaskImpl(alloc.new_method_task(
+        this, &object_scheduler::invokeCoalesced, std::make_tuple(key)));
+
+    return true;
+}
+
+void object_scheduler::invokeCoalesced(const size_t key)
+{
+    task_invoke_t* task = nullptr;
+
+    {
+        std::lock_guard lock{ coalesceMutex };
+
+        const auto entry = coalescedTasks.find(key);
+        MTBASE_ASSERT(entry != coalescedTasks.end());
+
+        task = entry->second;
+        coalescedTasks.erase(entry);
+    }
+
+    try
+    {
+        task->invoke();
+    }
+    catch (...)
     {
         alloc.delete_task(task);
+
+        throw;
     }
+
+    alloc.delete_task(task);
+}
+
+bool object_scheduler::registerReadTaskImpl(task_read_base_t* const task)
+{
+    return pushTask(lanes.front(), task, false, overflowPolicy);
+}
+
+void object_scheduler::beginRead(task_read_base_t* const task)
+{
+    cntReading.fetch_add(1, std::memory_order_seq_cst);
+
+    flusher.registerReadTask(task);
+}
+
+void object_scheduler::endRead()
+{
+    if (cntReading.fetch_sub(1, std::memory_order_seq_cst) == 1 &&
+        isParkedForReaders.exchange(false, std::memory_order_seq_cst))
+        resumeFromReaders();
+}
+
+void object_scheduler::parkForReaders()
+{
+    isParkedForReaders.store(true, std::memory_order_seq_cst);
+
+    if (cntReading.load(std::memory_order_seq_cst) == 0 &&
+        isParkedForReaders.exchange(false, std::memory_order_seq_cst))
+        resumeFromReaders();
+}
+
+void object_scheduler::resumeFromReaders()
+{
+    release();
+    flusher.registerFlushObjectTask(this);
 }
 
-void object_scheduler::registerTaskCuttingInImpl(task_invoke_t* const task)
+void object_scheduler::submitTaskImpl(task_invoke_t* const task)
 {
-    if (!storage->push_front(task))
+    try
+    {
+        submit_queue& queue = getLocalSubmitQueue();
+
+        while (true)
+        {
+            submit_entry& entry = acquireSubmitEntry(queue);
+
+            size_t cnt = entry.state.load(std::memory_order_acquire);
+            if (cnt >= MAX_SUBMIT_BATCH_SIZE)
+                continue;
+
+            entry.tasks[cnt] = task;
+            queue.cntPending.fetch_add(1);
+
+            // Fails only if another thread sealed the entry meanwhile; the
+            // task was not part of that commit, so it goes to a fresh entry.
+            if (!entry.state.compare_exchange_strong(cnt, cnt + 1,
+                std::memory_order_release, std::memory_order_relaxed))
+            {
+                queue.cntPending.fetch_sub(1);
+
+                continue;
+            }
+
+            if (cnt == 0 && thread_local_scheduler::current() == nullptr)
+            {
+                const steady_tick tickFirst{ entry.tickFirst.load(std::memory_order_relaxed) };
+                if (updateSubmitDeadline(tickFirst + MAX_SUBMIT_DELAY_TICK))
+                    flusher.wakeWorker();
+            }
+
+            if (cnt + 1 == MAX_SUBMIT_BATCH_SIZE)
+                static_cast<void>(tryCommitEntry(queue, entry));
+
+            return;
+        }
+    }
+    catch (...)
     {
         alloc.delete_task(task);
+
+        throw;
+    }
+}
+
+[[nodiscard]]
+object_scheduler::submit_entry& object_scheduler::acquireSubmitEntry(submit_queue& queue)
+{
+    submit_entry* freeEntry = nullptr;
+
+    for (submit_entry& entry : queue.entries)
+    {
+        const size_t state = entry.state.load(std::memory_order_acquire);
+        if ((state & submit_entry::STATE_FREE) != 0)
+        {
+            if (freeEntry == nullptr)
+                freeEntry = &entry;
+
+            continue;
+        }
+
+        if (entry.target.load(std::memory_order_relaxed) != this)
+            continue;
+
+        if ((state & submit_entry::STATE_SEALED) == 0)
+            return entry;
+
+        // Another thread is committing our earlier tasks. Wait for it so
+        // the tasks appended next cannot overtake them.
+        while ((entry.state.load(std::memory_order_acquire) & submit_entry::STATE_SEALED) != 0)
+            std::this_thread::yield();
+
+        return acquireSubmitEntry(queue);
+    }
+
+    if (freeEntry == nullptr)
+    {
+        // Every entry holds another object; commit one early to make room.
+        freeEntry = &queue.entries[queue.idxEvicted++ % MAX_SUBMIT_TARGET_COUNT];
+
+        if (!tryCommitEntry(queue, *freeEntry))
+        {
+            while ((freeEntry->state.load(std::memory_order_acquire) & submit_entry::STATE_FREE) == 0)
+                std::this_thread::yield();
+        }
+    }
+
+    freeEntry->target.store(this, std::memory_order_relaxed);
+    freeEntry->tickFirst.store(clock_t::getSteadyTick().count(), std::memory_order_relaxed);
+    freeEntry->state.store(0, std::memory_order_release);
+
+    return *freeEntry;
+}
+
+void object_scheduler::commitSubmits(task_invoke_t* const* const tasks, const size_t cnt)
+{
+    if (cnt == 1)
+    {
+        registerInternalTaskImpl(tasks[0]);
+
+        return;
+    }
+
+    try
+    {
+        std::pmr::vector<task_invoke_t*> batch{
+            tasks, tasks + cnt, submittedTasks.get_allocator().resource() };
+
+        registerInternalTaskImpl(alloc.new_method_task(
+            this, &object_scheduler::invokeSubmitted, std::make_tuple(std::move(batch))));
+    }
+    catch (...)
+    {
+        for (size_t i = 0; i < cnt; ++i)
+            alloc.delete_task(tasks[i]);
+
+        throw;
+    }
+}
+
+void object_scheduler::invokeSubmitted(const std::pmr::vector<task_invoke_t*>& tasks)
+{
+    try
+    {
+        submittedTasks.insert(submittedTasks.end(), tasks.begin(), tasks.end());
+    }
+    catch (...)
+    {
+        for (task_invoke_t* const task : tasks)
+            alloc.delete_task(task);
+
+        throw;
+    }
+}
+
+void object_scheduler::discardSubmits()
+    noexcept
+{
+    submit_registry& registry = getSubmitRegistry();
+    std::lock_guard lock{ registry.mutex };
+
+    for (submit_queue* const queue : registry.queues)
+    {
+        for (submit_entry& entry : queue->entries)
+        {
+            if (entry.target.load(std::memory_order_relaxed) != this)
+                continue;
+
+            size_t cnt = 0;
+            if (!trySealEntry(entry, cnt))
+                continue;
+
+            // The owner reused the entry for another object before we
+            // sealed it; hand it back untouched.
+            if (entry.target.load(std::memory_order_relaxed) != this)
+            {
+                entry.state.store(cnt, std::memory_order_release);
+
+                continue;
+            }
+
+            for (size_t i = 0; i < cnt; ++i)
+                alloc.delete_task(entry.tasks[i]);
+
+            freeEntry(*queue, entry, cnt);
+        }
+    }
+}
+
+[[nodiscard]]
+task_t* object_scheduler::popSubmittedTask()
+    noexcept
+{
+    if (idxSubmittedTask == submittedTasks.size())
+    {
+        submittedTasks.clear();
+        idxSubmittedTask = 0;
+
+        return nullptr;
+    }
+
+    return submittedTasks[idxSubmittedTask++];
+}
+
+[[nodiscard]]
+bool object_scheduler::trySealEntry(submit_entry& entry, size_t& cnt)
+    noexcept
+{
+    size_t state = entry.state.load(std::memory_order_acquire);
+
+    do
+    {
+        if ((state & (submit_entry::STATE_SEALED | submit_entry::STATE_FREE)) != 0)
+            return false;
+    } while (!entry.state.compare_exchange_weak(state, state | submit_entry::STATE_SEALED,
+        std::memory_order_acq_rel, std::memory_order_acquire));
+
+    cnt = state;
+
+    return true;
+}
+
+void object_scheduler::freeEntry(submit_queue& queue, submit_entry& entry, const size_t cnt)
+    noexcept
+{
+    queue.cntPending.fetch_sub(cnt);
+    entry.state.store(submit_entry::STATE_FREE, std::memory_order_release);
+}
+
+bool object_scheduler::tryCommitEntry(submit_queue& queue, submit_entry& entry)
+{
+    size_t cnt = 0;
+    if (!trySealEntry(entry, cnt))
+        return false;
+
+    // The owner waits on a sealed entry, so free it even if committing throws.
+    try
+    {
+        if (cnt > 0)
+            entry.target.load(std::memory_order_relaxed)->commitSubmits(entry.tasks.data(), cnt);
+    }
+    catch (...)
+    {
+        freeEntry(queue, entry, cnt);
+
+        throw;
     }
+
+    freeEntry(queue, entry, cnt);
+
+    return true;
+}
+
+void object_scheduler::commitQueue(submit_queue& queue)
+{
+    for (submit_entry& entry : queue.entries)
+        static_cast<void>(tryCommitEntry(queue, entry));
+}
+
+[[nodiscard]]
+bool object_scheduler::updateSubmitDeadline(const steady_tick tickDeadline)
+    noexcept
+{
+    std::atomic<steady_tick::rep>& deadline = getSubmitRegistry().tickDeadline;
+    steady_tick::rep oldDeadline = deadline.load(std::memory_order_relaxed);
+
+    while (tickDeadline.count() < oldDeadline)
+    {
+        if (deadline.compare_exchange_weak(oldDeadline, tickDeadline.count()))
+            return oldDeadline == steady_tick::max().count();
+    }
+
+    return false;
+}
+
+[[nodiscard]]
+object_scheduler::submit_queue& object_scheduler::getLocalSubmitQueue()
+{
+    if (localSubmitQueue.queue != nullptr)
+        return *localSubmitQueue.queue;
+
+    generic_allocator queueAlloc{ std::pmr::new_delete_resource() };
+    submit_queue* const queue = queueAlloc.new_object<submit_queue>();
+
+    try
+    {
+        submit_registry& registry = getSubmitRegistry();
+        std::lock_guard lock{ registry.mutex };
+
+        registry.queues.push_back(queue);
+    }
+    catch (...)
+    {
+        queueAlloc.delete_object(queue);
+
+        throw;
+    }
+
+    localSubmitQueue.queue = queue;
+
+    return *queue;
+}
+
+[[nodiscard]]
+object_scheduler::submit_registry& object_scheduler::getSubmitRegistry()
+    noexcept
+{
+    // Never destroyed: threads that exit after static destruction still
+    // unregister their submit queues here.
+    static submit_registry* const registry = new submit_registry{};
+
+    return *registry;
+}
+
+void object_scheduler::flushSubmits()
+{
+    submit_queue* const queue = localSubmitQueue.queue;
+    if (queue == nullptr || queue->cntPending.load(std::memory_order_relaxed) == 0)
+        return;
+
+    commitQueue(*queue);
+}
+
+void object_scheduler::flushExpiredSubmits()
+{
+    submit_registry& registry = getSubmitRegistry();
+    if (registry.tickDeadline.load(std::memory_order_acquire) == steady_tick::max().count())
+        return;
+
+    const steady_tick tickNow = clock_t::getSteadyTick();
+    if (tickNow.count() < registry.tickDeadline.load(std::memory_order_acquire))
+        return;
+
+    std::unique_lock lock{ registry.mutex, std::try_to_lock };
+    if (!lock.owns_lock())
+        return;
+
+    // A submitter that raced this reset counted its task first, so either
+    // the scan below sees it or its own deadline update lands afterwards.
+    registry.tickDeadline.store(steady_tick::max().count());
+
+    for (submit_queue* const queue : registry.queues)
+    {
+        if (queue->cntPending.load() == 0)
+            continue;
+
+        for (submit_entry& entry : queue->entries)
+        {
+            const size_t state = entry.state.load(std::memory_order_acquire);
+            if ((state & (submit_entry::STATE_SEALED | submit_entry::STATE_FREE)) != 0)
+                continue;
+
+            const steady_tick tickFirst{ entry.tickFirst.load(std::memory_order_relaxed) };
+            if (tickNow - tickFirst >= MAX_SUBMIT_DELAY_TICK)
+                static_cast<void>(tryCommitEntry(*queue, entry));
+            else
+                static_cast<void>(updateSubmitDeadline(tickFirst + MAX_SUBMIT_DELAY_TICK));
+        }
+    }
+}
+
+[[nodiscard]]
+steady_tick object_scheduler::getSubmitDeadline()
+    noexcept
+{
+    return steady_tick{
+        getSubmitRegistry().tickDeadline.load(std::memory_order_acquire) };
+}
+
+bool object_scheduler::pushTask(
+    priority_lane& lane,
+    task_invoke_t* const task,
+    const bool isCuttingIn,
+    const overflow_policy onOverflow)
+{
+    stampPending();
+
+    // Spilled cut-in tasks still hold the head of the lane, so a newer one
+    // spills ahead of them rather than landing behind them in the storage.
+    if (isCuttingIn && lane.cntOverflowCuttingIn.load(std::memory_order_acquire) > 0)
+        spillTask(lane, task, isCuttingIn);
+    else if (!tryPushTask(lane, task, isCuttingIn) &&
+        !handleOverflow(lane, task, isCuttingIn, onOverflow))
+        return false;
+
+    activate();
+
+    return true;
+}
+
+[[nodiscard]]
+bool object_scheduler::tryPushTask(
+    priority_lane& lane,
+    task_invoke_t* const task,
+    const bool isCuttingIn)
+{
+    if (isCuttingIn)
+        return lane.storage->push_front(task);
+
+    return lane.cntOverflow.load(std::memory_order_acquire) == 0 &&
+        lane.storage->push_back(task);
+}
+
+[[nodiscard]]
+bool object_scheduler::handleOverflow(
+    priority_lane& lane,
+    task_invoke_t* const task,
+    const bool isCuttingIn,
+    const overflow_policy onOverflow)
+{
+    switch (onOverflow)
+    {
+    case overflow_policy::BLOCK:
+        if (thread_local_scheduler::current() == nullptr)
+        {
+            pushTaskWithBackoff(lane, task, isCuttingIn);
+
+            return true;
+        }
+
+        [[fallthrough]];
+    case overflow_policy::SPILL:
+        spillTask(lane, task, isCuttingIn);
+
+        return true;
+    default:
+        alloc.delete_task(task);
+
+        return false;
+    }
+}
+
+void object_scheduler::pushTaskWithBackoff(
+    priority_lane& lane,
+    task_invoke_t* const task,
+    const bool isCuttingIn)
+{
+    steady_tick tickSleep{ std::chrono::microseconds{ 1 } };
+
+    for (size_t cntRetry = 0; !tryPushTask(lane, task, isCuttingIn); ++cntRetry)
+    {
+        if (cntRetry < MAX_BACKOFF_SPIN_COUNT)
+            _mm_pause();
+        else if (cntRetry < MAX_BACKOFF_SPIN_COUNT + MAX_BACKOFF_YIELD_COUNT)
+            std::this_thread::yield();
+        else
+        {
+            std::this_thread::sleep_for(tickSleep);
+            tickSleep = std::min(tickSleep * 2, MAX_BACKOFF_SLEEP_TICK);
+        }
+    }
+}
+
+void object_scheduler::spillTask(
+    priority_lane& lane,
+    task_invoke_t* const task,
+    const bool isCuttingIn)
+{
+    std::lock_guard<std::mutex> lock{ lane.overflowMutex };
+
+    if (isCuttingIn)
+    {
+        lane.overflowTasks.push_front(task);
+        lane.cntOverflowCuttingIn.fetch_add(1, std::memory_order_release);
+    }
+    else
+        lane.overflowTasks.push_back(task);
+
+    lane.cntOverflow.fetch_add(1, std::memory_order_release);
+}
+
+[[nodiscard]]
+task_t* object_scheduler::popLaneTask(priority_lane& lane)
+{
+    if (lane.cntOverflowCuttingIn.load(std::memory_order_acquire) > 0)
+    {
+        task_t* const cutInTask = popOverflowTask(lane);
+        if (cutInTask != nullptr)
+            return cutInTask;
+    }
+
+    task_t* const task = lane.storage->pop_front();
+
+    return task != nullptr ? task : popOverflowTask(lane);
+}
+
+[[nodiscard]]
+task_t* object_scheduler::popOverflowTask(priority_lane& lane)
+{
+    if (lane.cntOverflow.load(std::memory_order_acquire) == 0)
+        return nullptr;
+
+    std::lock_guard<std::mutex> lock{ lane.overflowMutex };
+
+    if (lane.overflowTasks.empty())
+        return nullptr;
+
+    task_t* const task = lane.overflowTasks.front();
+    lane.overflowTasks.pop_front();
+    lane.cntOverflow.fetch_sub(1, std::memory_order_release);
+
+    if (lane.cntOverflowCuttingIn.load(std::memory_order_relaxed) > 0)
+        lane.cntOverflowCuttingIn.fetch_sub(1, std::memory_order_release);
+
+    return task;
+}
+
+[[nodiscard]]
+bool object_scheduler::tryTransferAuthority(task_transaction_t* const task)
+    noexcept
+{
+    if ((state.load(std::memory_order_acquire) & STATE_RUNNING) == 0 ||
+        transferTask != nullptr)
+        return false;
+
+    transferTask = task;
+
+    return true;
+}
+
+void object_scheduler::resumeAuthority()
+{
+    const steady_tick tickOldest = getOldestPendingTick();
+
+    release();
+    flusher.registerFlushObjectTask(this, tickOldest);
+}
+
+[[nodiscard]]
+steady_tick object_scheduler::getOldestPendingTick()
+    noexcept
+{
+    if (cntBacklogExecuted < cntBacklog && tickBacklogSince != steady_tick{})
+    {
+        tickPendingSince.store(tickBacklogSince.count(), std::memory_order_relaxed);
+
+        return tickBacklogSince;
+    }
+
+    const steady_tick::rep tickSince =
+        tickPendingSince.load(std::memory_order_relaxed);
+
+    return tickSince != 0 ? steady_tick{ tickSince } : clock_t::getSteadyTick();
+}
+
+[[nodiscard]]
+size_t object_scheduler::getLastWorkerIndex()
+    const noexcept
+{
+    return lastWorkerIndex.load(std::memory_order_relaxed);
+}
+
+[[nodiscard]]
+object_scheduler* object_scheduler::current()
+    noexcept
+{
+    return currentSched;
+}
+
+[[nodiscard]]
+object_scheduler* object_scheduler::exchangeCurrent(object_scheduler* const sched)
+    noexcept
+{
+    return std::exchange(currentSched, sched);
+}
+
+[[nodiscard]]
+bool object_scheduler::shouldYield()
+    const noexcept
+{
+    if (isYieldRequested)
+        return true;
+
+    if (runningBlock == nullptr)
+        return false;
+
+    if (isYieldExpired)
+        return true;
+
+    const uint64_t cycleNow = __rdtsc();
+    if (cycleNow - cycleYieldChecked < YIELD_CHECK_CYCLE_COUNT)
+        return false;
+
+    cycleYieldChecked = cycleNow;
+    isYieldExpired = runningBlock->checkExpiredTick(
+        *runningRestriction, clock_t::getSteadyTick());
+
+    return isYieldExpired;
+}
+
+[[nodiscard]]
+bool mtbase::should_yield()
+    noexcept
+{
+    const object_scheduler* const sched = object_scheduler::current();
+
+    return sched != nullptr && sched->shouldYield();
+}
+
+void mtbase::flush_submits()
+{
+    object_scheduler::flushSubmits();
+}
+
+[[nodiscard]]
+timer_handle object_scheduler::registerTimedTaskImpl(
+    task_invoke_t* const task,
+    const steady_tick at,
+    const steady_tick period)
+{
+    timer_handle handle;
+    registerTimedTaskImpl(task, at, period, handle);
+
+    return handle;
+}
+
+void object_scheduler::registerTimedTaskImpl(
+    task_invoke_t* const task,
+    const steady_tick at,
+    const steady_tick period,
+    timer_handle& handle)
+{
+    task_timed_invoke_t* const timedTask =
+        alloc.new_timed_invoke_task(this, task, at, period);
+    handle = timer_handle{ timedTask };
+
+    thread_local_scheduler* const threadSched = thread_local_scheduler::current();
+    if (threadSched != nullptr)
+    {
+        timedTask->isArmed = true;
+        threadSched->getTimedScheduler().registerTimedTask(timedTask);
+    }
+    else
+        registerInternalTaskImpl(timedTask);
+}
+
+void object_scheduler::activate()
+{
+    const size_t oldState = state.fetch_or(STATE_SCHEDULED, std::memory_order_acq_rel);
+    if (oldState == STATE_IDLE)
+        flusher.registerNextFlushObjectTask(this);
 }
 
 void object_scheduler::flushOwned(thread_local_scheduler& threadSched)
 {
+    const scheduler_restriction restriction = controller.getRestriction();
     const steady_tick tickBegin = clock_t::getSteadyTick();
     control_block& block = threadSched.getControlBlock(this);
 
-    flushTasks(block);
+    object_scheduler* const prevSched = std::exchange(currentSched, this);
+    runningBlock = &block;
+    runningRestriction = &restriction;
+    isYieldExpired = false;
+    cycleYieldChecked = 0;
+
+    size_t cntExecuted = 0;
+    const bool isDrained = flushTasks(block, restriction, cntExecuted);
+
+    currentSched = prevSched;
+    runningBlock = nullptr;
+    runningRestriction = nullptr;
+
+    spillOwnedTasks();
 
     const steady_tick tickEnd = clock_t::getSteadyTick();
     
     block.recordTickFlushing(tickBegin, tickEnd);
+    controller.recordFlushing(tickBegin, tickEnd, cntExecuted);
+    cntBacklogExecuted += cntExecuted;
 
-    if (block.checkExpired(restriction, tickEnd))
+    if (std::exchange(isWaitingReaders, false))
     {
+        adapt();
         block.release();
+        parkForReaders();
+
+        return;
+    }
+
+    if (transferTask != nullptr)
+    {
+        task_transaction_t* const task = std::exchange(transferTask, nullptr);
+
+        adapt();
+        block.release();
+        task->acquireNext();
+
+        return;
+    }
+
+    if (isDrained)
+    {
+        adapt();
+        tickPendingSince.store(0, std::memory_order_relaxed);
+
+        block.release();
+
+        if (tryIdle())
+            return;
+
+        // A producer activated the object while it drained. Its SCHEDULED
+        // bit would fail every later tryIdle, so hand the object back to
+        // the flusher instead of spinning on an empty queue here.
+        isYieldRequested = false;
         release();
         flusher.registerFlushObjectTask(this);
 
         return;
     }
 
-    threadSched.registerMethodTask(this, &object_scheduler::flushOwned, threadSched);
+    if (std::exchange(isYieldRequested, false))
+    {
+        adapt();
+        block.release();
+        release();
+        flusher.registerYieldedFlushObjectTask(this);
+
+        return;
+    }
+
+    if (block.checkExpired(restriction, tickEnd))
+    {
+        const steady_tick tickOldest = getOldestPendingTick();
+
+        adapt();
+        block.release();
+        release();
+        flusher.registerFlushObjectTask(this, tickOldest);
+
+        return;
+    }
+
+    threadSched.registerMethodTask(this, &object_scheduler::continueOwned);
 }
 
-void object_scheduler::flushTasks(control_block& block)
+[[nodiscard]]
+bool object_scheduler::tryDispatch()
+{
+    const thread_local_scheduler* const threadSched = thread_local_scheduler::current();
+    if (threadSched == nullptr ||
+        cntDispatchDepth >= MAX_DISPATCH_DEPTH ||
+        getQueuedCount() > 0)
+        return false;
+
+    size_t oldState = STATE_IDLE;
+    if (!state.compare_exchange_strong(oldState, STATE_RUNNING,
+        std::memory_order_acq_rel, std::memory_order_relaxed))
+        return false;
+
+    if (cntReading.load(std::memory_order_seq_cst) > 0)
+    {
+        if (!tryIdle())
+        {
+            release();
+            flusher.registerFlushObjectTask(this);
+        }
+
+        return false;
+    }
+
+    lastWorkerIndex.store(threadSched->getWorkerIndex(), std::memory_order_relaxed);
+    dispatchingSched = std::exchange(currentSched, this);
+    ++cntDispatchDepth;
+
+    return true;
+}
+
+void object_scheduler::finishDispatch()
+{
+    --cntDispatchDepth;
+    currentSched = std::exchange(dispatchingSched, nullptr);
+    isYieldRequested = false;
+
+    if (tryIdle())
+        return;
+
+    release();
+    flusher.registerFlushObjectTask(this);
+}
+
+void object_scheduler::continueOwned()
+{
+    thread_local_scheduler* const threadSched = thread_local_scheduler::current();
+    MTBASE_ASSERT(threadSched != nullptr);
+
+    const size_t workerIndex = threadSched->getWorkerIndex();
+    if (lastWorkerIndex.exchange(workerIndex, std::memory_order_relaxed) != workerIndex)
+        threadSched->getControlBlock(this).reset();
+
+    flushOwned(*threadSched);
+}
+
+[[nodiscard]]
+bool object_scheduler::flushTasks(
+    control_block& block,
+    const scheduler_restriction& restriction,
+    size_t& cntExecuted)
 {
     for (size_t i = 0;
         i < restriction.MAX_FLUSH_COUNT_AT_ONCE &&
-        !block.checkExpiredCount(restriction);
+        !block.checkExpiredCount(restriction) &&
+        transferTask == nullptr &&
+        !isYieldRequested &&
+        !isWaitingReaders;
         ++i)
-        executeTask(block);
+    {
+        if (!executeTask(block, restriction))
+            return true;
+
+        ++cntExecuted;
+    }
+
+    return false;
 }
 
-void object_scheduler::executeTask(control_block& block)
+[[nodiscard]]
+bool object_scheduler::executeTask(
+    control_block& block,
+    const scheduler_restriction& restriction)
 {
-    task_t* const task = storage->pop_front();
+    task_t* const task = popTask();
     if (task == nullptr)
     {
         block.recordCountExpired(restriction);
 
-        return;
+        return false;
     }
 
-    invokeTask(block, task);
-    alloc.delete_task(task);
+    if (task->isReadOnly())
+    {
+        beginRead(static_cast<task_read_base_t*>(task));
+
+        return true;
+    }
+
+    if (cntReading.load(std::memory_order_seq_cst) > 0)
+    {
+        blockedTask = task;
+        isWaitingReaders = true;
+
+        return true;
+    }
+
+    const bool isReleased = task->isReleasedOnInvoke();
+
+    invokeTask(block, static_cast<task_invoke_t*>(task));
+
+    if (!isReleased)
+        alloc.delete_task(task);
+
+    return true;
+}
+
+[[nodiscard]]
+task_t* object_scheduler::popTask()
+{
+    if (blockedTask != nullptr)
+        return std::exchange(blockedTask, nullptr);
+
+    task_t* const submittedTask = popSubmittedTask();
+    if (submittedTask != nullptr)
+        return submittedTask;
+
+    task_t* const task = popQueuedTask();
+
+    return task != nullptr ? task : popOwnedTask();
+}
+
+[[nodiscard]]
+task_t* object_scheduler::popQueuedTask()
+{
+    if (lanes.size() == 1)
+        return popLaneTask(lanes.front());
+
+    priority_lane* selected = nullptr;
+    std::ptrdiff_t totalWeight = 0;
+
+    for (priority_lane& lane : lanes)
+    {
+        if (lane.storage->size() == 0 &&
+            lane.cntOverflow.load(std::memory_order_relaxed) == 0)
+            continue;
+
+        const std::ptrdiff_t weight = static_cast<std::ptrdiff_t>(lane.weight);
+
+        lane.credit += weight;
+        totalWeight += weight;
+
+        if (selected == nullptr || lane.credit > selected->credit)
+            selected = &lane;
+    }
+
+    if (selected != nullptr)
+    {
+        selected->credit -= totalWeight;
+
+        task_t* const task = popLaneTask(*selected);
+        if (task != nullptr)
+            return task;
+    }
+
+    for (auto lane = lanes.rbegin(); lane != lanes.rend(); ++lane)
+    {
+        task_t* const task = popLaneTask(*lane);
+        if (task != nullptr)
+            return task;
+    }
+
+    return nullptr;
+}
+
+[[nodiscard]]
+task_t* object_scheduler::popOwnedTask()
+    noexcept
+{
+    if (idxOwnedTask == ownedTasks.size())
+    {
+        ownedTasks.clear();
+        idxOwnedTask = 0;
+
+        return nullptr;
+    }
+
+    return ownedTasks[idxOwnedTask++];
+}
+
+void object_scheduler::spillOwnedTasks()
+{
+    for (; idxOwnedTask < ownedTasks.size(); ++idxOwnedTask)
+        pushTask(lanes.front(), ownedTasks[idxOwnedTask], false, overflow_policy::SPILL);
+
+    ownedTasks.clear();
+    idxOwnedTask = 0;
+}
+
+[[nodiscard]]
+size_t object_scheduler::getQueuedCount()
+    const noexcept
+{
+    size_t cntQueued = 0;
+    for (const priority_lane& lane : lanes)
+        cntQueued += lane.storage->size() +
+            lane.cntOverflow.load(std::memory_order_relaxed);
+
+    return cntQueued;
+}
+
+void object_scheduler::stampPending()
+    noexcept
+{
+    if (tickPendingSince.load(std::memory_order_relaxed) != 0)
+        return;
+
+    steady_tick::rep oldTick = 0;
+    tickPendingSince.compare_exchange_strong(oldTick,
+        clock_t::getSteadyTick().count(), std::memory_order_relaxed);
+}
+
+void object_scheduler::beginBacklog()
+    noexcept
+{
+    tickBacklogSince = steady_tick{
+        tickPendingSince.exchange(0, std::memory_order_relaxed) };
+    cntBacklog = getQueuedCount();
+    cntBacklogExecuted = 0;
+}
+
+void object_scheduler::adapt()
+    noexcept
+{
+    if (!controller.isAdaptive())
+        return;
+
+    controller.update(getQueuedCount(), flusher.getBacklogPerWorker());
 }
 
 void object_scheduler::invokeTask(
@@ -94,14 +1272,23 @@ void object_scheduler::invokeTask(
     block.recordCountFlushing();
 }
 
+[[nodiscard]]
 bool object_scheduler::tryOwn() noexcept
 {
-    bool oldOwned = false;
-    return isOwned.compare_exchange_strong(oldOwned, true,
+    size_t oldState = STATE_SCHEDULED;
+    return state.compare_exchange_strong(oldState, STATE_RUNNING,
+        std::memory_order_acq_rel, std::memory_order_acquire);
+}
+
+[[nodiscard]]
+bool object_scheduler::tryIdle() noexcept
+{
+    size_t oldState = STATE_RUNNING;
+    return state.compare_exchange_strong(oldState, STATE_IDLE,
         std::memory_order_acq_rel, std::memory_order_acquire);
 }
 
 void object_scheduler::release() noexcept
 {
-    isOwned.store(false, std::memory_order_release);
+    state.store(STATE_SCHEDULED, std::memory_order_release);
 }
@@ -0,0 +1,86 @@
+#include "../include/sentifer_mtbase/details/restriction_controller.h"
+
+#include <algorithm>
+
+using namespace mtbase;
+
+[[nodiscard]]
+scheduler_restriction restriction_controller::getRestriction()
+    const noexcept
+{
+    return scheduler_restriction{
+        tickOccupy,
+        tickOccupyFlushing,
+        cntFlush,
+        cntFlushAtOnce };
+}
+
+[[nodiscard]]
+bool restriction_controller::isAdaptive()
+    const noexcept
+{
+    return policy.has_value();
+}
+
+void restriction_controller::recordFlushing(
+    const steady_tick tickBegin,
+    const steady_tick tickEnd,
+    const size_t cntExecuted)
+    noexcept
+{
+    tickSampled += (tickEnd - tickBegin);
+    cntSampled += cntExecuted;
+}
+
+void restriction_controller::update(
+    const size_t cntQueued,
+    const size_t cntBacklogPerWorker)
+    noexcept
+{
+    if (cntSampled > 0)
+        tickTaskCost = smooth(tickTaskCost,
+            tickSampled / static_cast<steady_tick::rep>(cntSampled));
+
+    tickSampled = steady_tick{};
+    cntSampled = 0;
+
+    if (!isAdaptive())
+        return;
+
+    const scheduler_restriction& lower = policy->MIN_RESTRICTION;
+    const scheduler_restriction& upper = policy->MAX_RESTRICTION;
+
+    const steady_tick tickSlice = std::clamp(
+        policy->TARGET_LATENCY_TICK /
+            static_cast<steady_tick::rep>(cntBacklogPerWorker + 1),
+        lower.MAX_OCCUPY_TICK, upper.MAX_OCCUPY_TICK);
+
+    tickOccupy = smooth(tickOccupy, tickSlice);
+    tickOccupyFlushing = std::clamp(tickOccupy,
+        lower.MAX_OCCUPY_TICK_FLUSHING, upper.MAX_OCCUPY_TICK_FLUSHING);
+
+    const size_t cntAffordable = tickTaskCost > steady_tick{} ?
+        static_cast<size_t>(tickOccupyFlushing / tickTaskCost) :
+        upper.MAX_FLUSH_COUNT;
+
+    cntFlush = std::clamp(cntAffordable,
+        lower.MAX_FLUSH_COUNT, upper.MAX_FLUSH_COUNT);
+    cntFlushAtOnce = std::clamp(std::min(cntQueued, cntFlush),
+        lower.MAX_FLUSH_COUNT_AT_ONCE, upper.MAX_FLUSH_COUNT_AT_ONCE);
+}
+
+[[nodiscard]]
+steady_tick restriction_controller::smooth(
+    const steady_tick tickOld,
+    const steady_tick tickNew)
+    noexcept
+{
+    if (tickOld == steady_tick{})
+        return tickNew;
+
+    const steady_tick tickStep = (tickNew - tickOld) / (1 << SMOOTHING_SHIFT);
+
+    // The shift rounds steps under one tick to zero, which would leave the
+    // value stuck short of the target; that close, take the target instead.
+    return tickStep != steady_tick{} ? tickOld + tickStep : tickNew;
+}
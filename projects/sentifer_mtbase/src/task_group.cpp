@@ -0,0 +1,57 @@
+#include "../include/sentifer_mtbase/details/task_group.h"
+
+#include <thread>
+#include <utility>
+
+#include "../include/sentifer_mtbase/details/schedulers/object_flush_scheduler.h"
+
+using namespace mtbase;
+
+void task_group::wait()
+{
+    while (!isDone())
+    {
+        thread_local_scheduler* const threadSched = thread_local_scheduler::current();
+        if (threadSched == nullptr || !threadSched->helpOnce())
+            std::this_thread::yield();
+    }
+
+    if (!isFailed.load(std::memory_order_acquire))
+        return;
+
+    std::exception_ptr failure = std::exchange(exception, nullptr);
+    isFailed.store(false, std::memory_order_relaxed);
+
+    std::rethrow_exception(failure);
+}
+
+[[nodiscard]]
+bool task_group::isDone()
+    const noexcept
+{
+    return cntPending.load(std::memory_order_acquire) == 0;
+}
+
+[[nodiscard]]
+std::pmr::memory_resource* task_group::getResource()
+    const noexcept
+{
+    return alloc.resource();
+}
+
+void task_group::arrive(std::exception_ptr&& failure)
+    noexcept
+{
+    if (failure && !isFailed.exchange(true, std::memory_order_relaxed))
+        exception = std::move(failure);
+
+    cntPending.fetch_sub(1, std::memory_order_release);
+}
+
+void task_group::spawnImpl(task_invoke_t* const task)
+{
+    cntPending.fetch_add(1, std::memory_order_relaxed);
+
+    if (!flusher.tryRegisterGroupTask(task))
+        task->invoke();
+}
@@ -1,10 +1,303 @@
 #include "../include/sentifer_mtbase/details/tasks.hpp"
 
+#include <algorithm>
+
+#include "../include/sentifer_mtbase/details/task_allocator.hpp"
 #include "../include/sentifer_mtbase/details/schedulers/object_scheduler.h"
+#include "../include/sentifer_mtbase/details/schedulers/thread_local_scheduler.h"
+#include "../include/sentifer_mtbase/details/schedulers/timed_object_scheduler.h"
 
 using namespace mtbase;
 
+void task_resume_t::invoke()
+{
+    handle.resume();
+}
+
+[[nodiscard]]
+bool task_resume_t::tryReleaseIntrusive()
+    noexcept
+{
+    return true;
+}
+
+[[nodiscard]]
+bool task_resume_t::isReleasedOnInvoke()
+    const noexcept
+{
+    return true;
+}
+
+void task_ask_base_t::invoke()
+{
+    if (isReplying)
+    {
+        reply();
+
+        return;
+    }
+
+    request();
+
+    if (isSettled.exchange(true, std::memory_order_acq_rel))
+        return;
+
+    timer.cancel();
+
+    isReplying = true;
+    acquire();
+    replySched->registerAskTask(this);
+}
+
+[[nodiscard]]
+bool task_ask_base_t::tryReleaseIntrusive()
+    noexcept
+{
+    release();
+
+    return true;
+}
+
+void task_ask_base_t::armTimeout(const steady_tick at)
+{
+    acquire();
+    timer = replySched->registerAskTimeoutTask(at, &timeoutTask);
+}
+
+void task_ask_base_t::acquire()
+    noexcept
+{
+    cntRef.fetch_add(1, std::memory_order_relaxed);
+}
+
+void task_ask_base_t::release()
+    noexcept
+{
+    if (cntRef.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        destroy();
+}
+
+void task_ask_base_t::task_timeout_t::invoke()
+{
+    if (!owner.isSettled.exchange(true, std::memory_order_acq_rel))
+        owner.timeout();
+}
+
+[[nodiscard]]
+bool task_ask_base_t::task_timeout_t::tryReleaseIntrusive()
+    noexcept
+{
+    owner.release();
+
+    return true;
+}
+
+void task_read_base_t::invoke()
+{
+    object_scheduler* const sched = ownerSched;
+
+    try
+    {
+        read();
+    }
+    catch (...)
+    {
+        destroy();
+        sched->endRead();
+
+        throw;
+    }
+
+    destroy();
+    sched->endRead();
+}
+
+[[nodiscard]]
+bool task_read_base_t::isReleasedOnInvoke()
+    const noexcept
+{
+    return true;
+}
+
+[[nodiscard]]
+bool task_read_base_t::isReadOnly()
+    const noexcept
+{
+    return true;
+}
+
 void task_flush_object_t::invoke(thread_local_scheduler& threadSched)
 {
     objectSched->flush(threadSched);
 }
+
+[[nodiscard]]
+steady_tick task_flush_object_t::getDeadline()
+    const noexcept
+{
+    return tickDeadline;
+}
+
+void task_timed_invoke_t::invoke()
+{
+    if (!isArmed)
+    {
+        thread_local_scheduler* const threadSched = thread_local_scheduler::current();
+        MTBASE_ASSERT(threadSched != nullptr);
+
+        isArmed = true;
+        acquire();
+        threadSched->getTimedScheduler().registerTimedTask(this);
+
+        return;
+    }
+
+    if (isCancelled())
+        return;
+
+    isTargetReleased = targetTask->isReleasedOnInvoke();
+    targetTask->invoke();
+}
+
+[[nodiscard]]
+bool task_timed_invoke_t::tryReleaseIntrusive()
+    noexcept
+{
+    release();
+
+    return true;
+}
+
+void task_timed_invoke_t::acquire()
+    noexcept
+{
+    cntRef.fetch_add(1, std::memory_order_relaxed);
+}
+
+void task_timed_invoke_t::release()
+    noexcept
+{
+    if (cntRef.fetch_sub(1, std::memory_order_acq_rel) != 1)
+        return;
+
+    if (!isTargetReleased)
+        task_allocator{ resource }.delete_task(targetTask);
+
+    generic_allocator{ resource }.delete_object(this);
+}
+
+[[nodiscard]]
+bool task_timed_invoke_t::cancel()
+    noexcept
+{
+    return !cancelled.exchange(true, std::memory_order_acq_rel);
+}
+
+[[nodiscard]]
+bool task_timed_invoke_t::isCancelled()
+    const noexcept
+{
+    return cancelled.load(std::memory_order_acquire);
+}
+
+[[nodiscard]]
+bool task_timed_invoke_t::isPeriodic()
+    const noexcept
+{
+    return tickPeriod > steady_tick{};
+}
+
+void task_flush_timed_object_t::invoke()
+{
+    static_cast<void>(timedObjectSched->flush());
+}
+
+task_transaction_t::task_transaction_t(
+    std::pmr::memory_resource* const res,
+    std::span<object_scheduler* const> scheds,
+    task_invoke_t* const body) :
+    task_invoke_t{},
+    objectScheds{ scheds.begin(), scheds.end(), res },
+    bodyTask{ body },
+    resource{ res }
+{
+    std::sort(objectScheds.begin(), objectScheds.end(),
+        std::less<object_scheduler*>{});
+    objectScheds.erase(
+        std::unique(objectScheds.begin(), objectScheds.end()),
+        objectScheds.end());
+
+    MTBASE_ASSERT(!objectScheds.empty());
+}
+
+void task_transaction_t::invoke()
+{
+    object_scheduler* const objectSched = objectScheds[cntAcquired++];
+
+    if (cntAcquired == objectScheds.size())
+    {
+        try
+        {
+            bodyTask->invoke();
+        }
+        catch (...)
+        {
+            resumeAcquired();
+
+            throw;
+        }
+
+        resumeAcquired();
+
+        return;
+    }
+
+    const bool isTransferred = objectSched->tryTransferAuthority(this);
+    MTBASE_ASSERT(isTransferred);
+
+    acquire();
+}
+
+[[nodiscard]]
+bool task_transaction_t::tryReleaseIntrusive()
+    noexcept
+{
+    release();
+
+    return true;
+}
+
+void task_transaction_t::acquireNext()
+{
+    objectScheds[cntAcquired]->registerTransactionTask(this);
+}
+
+[[nodiscard]]
+object_scheduler* task_transaction_t::getFirstScheduler()
+    const noexcept
+{
+    return objectScheds.front();
+}
+
+void task_transaction_t::resumeAcquired()
+{
+    // The last object is the one running the body; its flush releases it.
+    for (size_t i = 0; i + 1 < objectScheds.size(); ++i)
+        objectScheds[i]->resumeAuthority();
+}
+
+void task_transaction_t::acquire()
+    noexcept
+{
+    cntRef.fetch_add(1, std::memory_order_relaxed);
+}
+
+void task_transaction_t::release()
+    noexcept
+{
+    if (cntRef.fetch_sub(1, std::memory_order_acq_rel) != 1)
+        return;
+
+    task_allocator{ resource }.delete_task(bodyTask);
+    generic_allocator{ resource }.delete_object(this);
+}
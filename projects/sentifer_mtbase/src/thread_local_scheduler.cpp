@@ -1,45 +1,278 @@
 #include "../include/sentifer_mtbase/details/schedulers/thread_local_scheduler.h"
 
+#include <thread>
+#include <utility>
+#include <immintrin.h>
+
 #include "../include/sentifer_mtbase/details/base_structures.hpp"
 #include "../include/sentifer_mtbase/details/schedulers/object_flush_scheduler.h"
+#include "../include/sentifer_mtbase/details/schedulers/object_scheduler.h"
 
 using namespace mtbase;
 
+thread_local thread_local_scheduler* thread_local_scheduler::currentSched{ nullptr };
+
 void thread_local_scheduler::flush()
 {
-    flusher.flush(*this);
+    currentSched = this;
+    flusher.attachWorker(*this);
+
+    size_t cntIdle = 0;
 
     while (true)
     {
-        flushRequested();
+        if (flushOnce(cntIdle))
+        {
+            cntIdle = 0;
+
+            continue;
+        }
 
-        // task stealing
+        // Checked only once idle, so work queued before the stop still runs.
+        if (flusher.isStopRequested())
+            break;
 
-        // default task
+        idle(cntIdle);
     }
+
+    flusher.detachWorker(*this);
+    currentSched = nullptr;
 }
 
-void thread_local_scheduler::registerTaskImpl(task_invoke_t* const task)
+[[nodiscard]]
+thread_local_scheduler* thread_local_scheduler::current()
+    noexcept
 {
-    if (!storage->push_back(task))
+    return currentSched;
+}
+
+[[nodiscard]]
+object_flush_scheduler& thread_local_scheduler::getFlusher()
+    const noexcept
+{
+    return flusher;
+}
+
+[[nodiscard]]
+timed_object_scheduler& thread_local_scheduler::getTimedScheduler()
+    noexcept
+{
+    return timedSched;
+}
+
+[[nodiscard]]
+size_t thread_local_scheduler::getWorkerIndex()
+    const noexcept
+{
+    return index;
+}
+
+[[nodiscard]]
+bool thread_local_scheduler::pushRequestedTask(task_invoke_t* const task)
+{
+    return storage->push_back(task);
+}
+
+[[nodiscard]]
+bool thread_local_scheduler::pushGroupTask(task_invoke_t* const task)
+{
+    return groupTasks->push_back(task);
+}
+
+[[nodiscard]]
+task_t* thread_local_scheduler::popGroupTask()
+{
+    return groupTasks->pop_front();
+}
+
+[[nodiscard]]
+bool thread_local_scheduler::hasGroupTask()
+    const noexcept
+{
+    return groupTasks->size() > 0;
+}
+
+[[nodiscard]]
+bool thread_local_scheduler::helpOnce()
+{
+    // The owner takes its newest split first and thieves the oldest, so
+    // neither walks into the other's end of the deque.
+    task_t* task = groupTasks->pop_back();
+    if (task == nullptr)
+        task = flusher.stealGroupTask(*this);
+
+    if (task == nullptr)
+        return false;
+
+    // A task waiting on its group may be an object's; the helped task is not.
+    object_scheduler* const waitingSched = object_scheduler::exchangeCurrent(nullptr);
+
+    try
     {
-        alloc.delete_task(task);
+        executeTask(task);
+    }
+    catch (...)
+    {
+        static_cast<void>(object_scheduler::exchangeCurrent(waitingSched));
+
+        throw;
+    }
+
+    static_cast<void>(object_scheduler::exchangeCurrent(waitingSched));
+
+    return true;
+}
+
+[[nodiscard]]
+task_t* thread_local_scheduler::exchangeNextTask(task_t* const task)
+    noexcept
+{
+    return nextTask.exchange(task, std::memory_order_acq_rel);
+}
+
+[[nodiscard]]
+task_t* thread_local_scheduler::takeNextTask()
+    noexcept
+{
+    if (nextTask.load(std::memory_order_relaxed) == nullptr ||
+        cntNextTaskStreak >= MAX_NEXT_TASK_STREAK)
+    {
+        cntNextTaskStreak = 0;
+
+        return nullptr;
     }
+
+    ++cntNextTaskStreak;
+
+    return nextTask.exchange(nullptr, std::memory_order_acq_rel);
+}
+
+[[nodiscard]]
+task_t* thread_local_scheduler::stealNextTask()
+    noexcept
+{
+    if (nextTask.load(std::memory_order_relaxed) == nullptr)
+        return nullptr;
+
+    return nextTask.exchange(nullptr, std::memory_order_acq_rel);
+}
+
+bool thread_local_scheduler::registerTaskImpl(task_invoke_t* const task)
+{
+    if (!storage->push_back(task))
+        flusher.injectTask(task);
+
+    return true;
+}
+
+[[nodiscard]]
+bool thread_local_scheduler::flushOnce(const size_t cntIdle)
+{
+    object_scheduler::flushSubmits();
+    object_scheduler::flushExpiredSubmits();
+
+    const bool isTimedFlushed = timedSched.flush();
+    const bool isRequestedFlushed = flushRequested() || helpOnce();
+    const bool isObjectFlushed = flusher.flush(
+        *this, cntIdle >= policy.MAX_SPIN_COUNT + policy.MAX_YIELD_COUNT);
+    const bool isBusy = isTimedFlushed || isRequestedFlushed || isObjectFlushed;
+
+    if (isBusy && ++cntFlushOnce % INJECTOR_POLL_INTERVAL != 0)
+        return true;
+
+    return flushInjected() || isBusy;
 }
 
-void thread_local_scheduler::flushRequested()
+[[nodiscard]]
+bool thread_local_scheduler::flushRequested()
 {
+    bool isFlushed = false;
+
     while (true)
     {
         task_t* const task = storage->pop_front();
         if (task == nullptr)
-            return;
+            return isFlushed;
 
-        invokeTask(task);
-        alloc.delete_task(task);
+        executeTask(task);
+
+        isFlushed = true;
     }
 }
 
+[[nodiscard]]
+bool thread_local_scheduler::flushInjected()
+{
+    size_t cntFlushed = 0;
+
+    for (; cntFlushed < MAX_INJECTED_FLUSH_COUNT; ++cntFlushed)
+    {
+        task_t* const task = flusher.popInjectedTask();
+        if (task == nullptr)
+            break;
+
+        executeTask(task);
+    }
+
+    return cntFlushed > 0;
+}
+
+void thread_local_scheduler::idle(size_t& cntIdle)
+{
+    if (cntIdle < policy.MAX_SPIN_COUNT)
+    {
+        _mm_pause();
+        ++cntIdle;
+
+        return;
+    }
+
+    if (cntIdle < policy.MAX_SPIN_COUNT + policy.MAX_YIELD_COUNT)
+    {
+        std::this_thread::yield();
+        ++cntIdle;
+
+        return;
+    }
+
+    park(cntIdle);
+}
+
+void thread_local_scheduler::park(size_t& cntIdle)
+{
+    event_count& idleEvent = flusher.getIdleEvent();
+    const size_t key = idleEvent.prepareWait();
+
+    if (flusher.isStopRequested())
+    {
+        idleEvent.cancelWait();
+
+        return;
+    }
+
+    if (flushOnce(cntIdle))
+    {
+        idleEvent.cancelWait();
+        cntIdle = 0;
+
+        return;
+    }
+
+    idleEvent.wait(key, std::min(
+        timedSched.getNextExpiry(clock_t::getSteadyTick() + policy.MAX_PARK_TICK),
+        object_scheduler::getSubmitDeadline()));
+}
+
+void thread_local_scheduler::executeTask(task_t* const task)
+{
+    const bool isReleased = task->isReleasedOnInvoke();
+
+    invokeTask(static_cast<task_invoke_t*>(task));
+
+    if (!isReleased)
+        alloc.delete_task(task);
+}
+
 void thread_local_scheduler::invokeTask(task_t* const task)
     const
 {}
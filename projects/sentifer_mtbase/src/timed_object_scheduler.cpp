@@ -0,0 +1,81 @@
+#include "../include/sentifer_mtbase/details/schedulers/timed_object_scheduler.h"
+
+#include "../include/sentifer_mtbase/details/tasks.hpp"
+#include "../include/sentifer_mtbase/details/schedulers/object_scheduler.h"
+
+using namespace mtbase;
+
+void timed_object_scheduler::registerTimedTask(task_timed_invoke_t* const task)
+    noexcept
+{
+    wheel.insert(task);
+}
+
+void timed_object_scheduler::cancelTimedTask(task_timed_invoke_t* const task)
+    noexcept
+{
+    if (!isOwnerOf(task))
+        return;
+
+    wheel.erase(task);
+    task->release();
+}
+
+[[nodiscard]]
+bool timed_object_scheduler::flush()
+{
+    const steady_tick tickNow = clock_t::getSteadyTick();
+    task_timed_invoke_t* task = wheel.advance(tickNow);
+    if (task == nullptr)
+        return false;
+
+    while (task != nullptr)
+    {
+        task_timed_invoke_t* const next = task->next;
+        task->next = nullptr;
+
+        fireTask(task, tickNow);
+
+        task = next;
+    }
+
+    return true;
+}
+
+[[nodiscard]]
+steady_tick timed_object_scheduler::getNextExpiry(const steady_tick tickLimit)
+    const noexcept
+{
+    return wheel.getNextExpiry(tickLimit);
+}
+
+[[nodiscard]]
+bool timed_object_scheduler::isOwnerOf(const task_timed_invoke_t* const task)
+    const noexcept
+{
+    return task->wheel.load(std::memory_order_relaxed) == &wheel;
+}
+
+void timed_object_scheduler::fireTask(
+    task_timed_invoke_t* const task,
+    const steady_tick tickNow)
+{
+    if (task->isCancelled())
+    {
+        task->release();
+
+        return;
+    }
+
+    if (task->isPeriodic())
+    {
+        do
+            task->tickExpiredAt += task->tickPeriod;
+        while (task->tickExpiredAt <= tickNow);
+
+        task->acquire();
+        wheel.insert(task);
+    }
+
+    task->objectSched->registerExpiredTask(task);
+}
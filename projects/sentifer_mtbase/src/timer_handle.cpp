@@ -0,0 +1,67 @@
+#include "../include/sentifer_mtbase/details/timer_handle.h"
+
+#include "../include/sentifer_mtbase/details/tasks.hpp"
+#include "../include/sentifer_mtbase/details/schedulers/thread_local_scheduler.h"
+#include "../include/sentifer_mtbase/details/schedulers/timed_object_scheduler.h"
+
+using namespace mtbase;
+
+timer_handle::timer_handle(task_timed_invoke_t* const task) noexcept :
+    timedTask{ task }
+{
+    if (timedTask != nullptr)
+        timedTask->acquire();
+}
+
+timer_handle::timer_handle(timer_handle&& other) noexcept :
+    timedTask{ other.timedTask }
+{
+    other.timedTask = nullptr;
+}
+
+timer_handle::~timer_handle()
+{
+    reset();
+}
+
+timer_handle& timer_handle::operator=(timer_handle&& other) noexcept
+{
+    if (this != &other)
+    {
+        reset();
+
+        timedTask = other.timedTask;
+        other.timedTask = nullptr;
+    }
+
+    return *this;
+}
+
+bool timer_handle::cancel()
+    noexcept
+{
+    if (timedTask == nullptr || !timedTask->cancel())
+        return false;
+
+    thread_local_scheduler* const threadSched = thread_local_scheduler::current();
+    if (threadSched != nullptr)
+        threadSched->getTimedScheduler().cancelTimedTask(timedTask);
+
+    return true;
+}
+
+void timer_handle::reset()
+    noexcept
+{
+    if (timedTask != nullptr)
+        timedTask->release();
+
+    timedTask = nullptr;
+}
+
+[[nodiscard]]
+timer_handle::operator bool()
+    const noexcept
+{
+    return timedTask != nullptr;
+}
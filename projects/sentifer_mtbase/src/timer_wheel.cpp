@@ -0,0 +1,230 @@
+#include "../include/sentifer_mtbase/details/timer_wheel.h"
+
+#include <algorithm>
+#include <bit>
+
+#include "../include/sentifer_mtbase/details/tasks.hpp"
+
+using namespace mtbase;
+
+timer_wheel::~timer_wheel()
+{
+    for (auto& level : slots)
+    {
+        for (task_timed_invoke_t*& head : level)
+        {
+            task_timed_invoke_t* task = head;
+            head = nullptr;
+
+            while (task != nullptr)
+            {
+                task_timed_invoke_t* const next = task->next;
+
+                task->wheel.store(nullptr, std::memory_order_relaxed);
+                task->prev = nullptr;
+                task->next = nullptr;
+                task->release();
+
+                task = next;
+            }
+        }
+    }
+
+    occupied.fill(0);
+    cnt = 0;
+}
+
+void timer_wheel::insert(task_timed_invoke_t* const task)
+    noexcept
+{
+    const uint64_t tickSlot =
+        std::max(toWheelTickCeil(task->tickExpiredAt), tickCurrent + 1);
+
+    task->wheel.store(this, std::memory_order_relaxed);
+    link(task, tickSlot);
+
+    ++cnt;
+}
+
+void timer_wheel::erase(task_timed_invoke_t* const task)
+    noexcept
+{
+    task_timed_invoke_t*& head = slots[task->level][task->slot];
+
+    if (task->prev != nullptr)
+        task->prev->next = task->next;
+    else
+        head = task->next;
+
+    if (task->next != nullptr)
+        task->next->prev = task->prev;
+
+    if (head == nullptr)
+        occupied[task->level] &= ~(uint64_t{ 1 } << task->slot);
+
+    task->prev = nullptr;
+    task->next = nullptr;
+    task->wheel.store(nullptr, std::memory_order_relaxed);
+
+    --cnt;
+}
+
+[[nodiscard]]
+task_timed_invoke_t* timer_wheel::advance(const steady_tick tickNow)
+    noexcept
+{
+    const uint64_t tickTarget = toWheelTick(tickNow);
+    task_timed_invoke_t* expired = nullptr;
+
+    while (tickCurrent < tickTarget)
+    {
+        if (cnt == 0)
+        {
+            tickCurrent = tickTarget;
+
+            break;
+        }
+
+        size_t cntEmptyLevel = 0;
+        while (occupied[cntEmptyLevel] == 0)
+            ++cntEmptyLevel;
+
+        if (cntEmptyLevel > 0)
+        {
+            const uint64_t tickBoundary = tickCurrent |
+                ((uint64_t{ 1 } << (SLOT_BITS * cntEmptyLevel)) - 1);
+            if (tickBoundary >= tickTarget)
+            {
+                tickCurrent = tickTarget;
+
+                break;
+            }
+
+            tickCurrent = tickBoundary;
+        }
+
+        ++tickCurrent;
+
+        for (size_t level = LEVEL_COUNT - 1; level > 0; --level)
+        {
+            if ((tickCurrent & ((uint64_t{ 1 } << (SLOT_BITS * level)) - 1)) == 0)
+                cascade(level);
+        }
+
+        collect(expired);
+    }
+
+    return expired;
+}
+
+[[nodiscard]]
+steady_tick timer_wheel::getNextExpiry(const steady_tick tickLimit)
+    const noexcept
+{
+    if (cnt == 0)
+        return tickLimit;
+
+    uint64_t tickNext = (tickCurrent | (SLOT_COUNT - 1)) + 1;
+    if (occupied[0] != 0)
+    {
+        const size_t base = (tickCurrent + 1) & (SLOT_COUNT - 1);
+        tickNext = tickCurrent + 1 +
+            std::countr_zero(std::rotr(occupied[0], static_cast<int>(base)));
+    }
+
+    return std::min(tickLimit, steady_tick{
+        static_cast<steady_tick::rep>(tickNext) * resolution.count() });
+}
+
+[[nodiscard]]
+size_t timer_wheel::size()
+    const noexcept
+{
+    return cnt;
+}
+
+void timer_wheel::link(
+    task_timed_invoke_t* const task,
+    const uint64_t tickSlot)
+    noexcept
+{
+    const uint64_t delta = std::min(tickSlot - tickCurrent, MAX_DELTA);
+    const uint64_t tickPlaced = tickCurrent + delta;
+
+    size_t level = 0;
+    while (level + 1 < LEVEL_COUNT &&
+        delta >= (uint64_t{ 1 } << (SLOT_BITS * (level + 1))))
+        ++level;
+
+    const size_t slot = (tickPlaced >> (SLOT_BITS * level)) & (SLOT_COUNT - 1);
+    task_timed_invoke_t*& head = slots[level][slot];
+
+    task->level = level;
+    task->slot = slot;
+    task->prev = nullptr;
+    task->next = head;
+
+    if (head != nullptr)
+        head->prev = task;
+
+    head = task;
+    occupied[level] |= uint64_t{ 1 } << slot;
+}
+
+void timer_wheel::cascade(const size_t level)
+    noexcept
+{
+    const size_t slot = (tickCurrent >> (SLOT_BITS * level)) & (SLOT_COUNT - 1);
+    task_timed_invoke_t* task = slots[level][slot];
+
+    slots[level][slot] = nullptr;
+    occupied[level] &= ~(uint64_t{ 1 } << slot);
+
+    while (task != nullptr)
+    {
+        task_timed_invoke_t* const next = task->next;
+
+        link(task, std::max(toWheelTickCeil(task->tickExpiredAt), tickCurrent));
+
+        task = next;
+    }
+}
+
+void timer_wheel::collect(task_timed_invoke_t*& expired)
+    noexcept
+{
+    const size_t slot = tickCurrent & (SLOT_COUNT - 1);
+    task_timed_invoke_t* task = slots[0][slot];
+
+    slots[0][slot] = nullptr;
+    occupied[0] &= ~(uint64_t{ 1 } << slot);
+
+    while (task != nullptr)
+    {
+        task_timed_invoke_t* const next = task->next;
+
+        task->wheel.store(nullptr, std::memory_order_relaxed);
+        task->prev = nullptr;
+        task->next = expired;
+        expired = task;
+
+        --cnt;
+
+        task = next;
+    }
+}
+
+[[nodiscard]]
+uint64_t timer_wheel::toWheelTick(const steady_tick tick)
+    const noexcept
+{
+    return static_cast<uint64_t>(tick.count() / resolution.count());
+}
+
+[[nodiscard]]
+uint64_t timer_wheel::toWheelTickCeil(const steady_tick tick)
+    const noexcept
+{
+    return static_cast<uint64_t>(
+        (tick.count() + resolution.count() - 1) / resolution.count());
+}
@@ -0,0 +1,15 @@
+#include "../include/sentifer_mtbase/details/schedulers/transaction_scheduler.h"
+
+#include "../include/sentifer_mtbase/details/schedulers/object_scheduler.h"
+
+using namespace mtbase;
+
+void transaction_scheduler::registerTransactionImpl(
+    std::span<object_scheduler* const> objectScheds,
+    task_invoke_t* const bodyTask)
+{
+    task_transaction_t* const task =
+        alloc.new_transaction_task(objectScheds, bodyTask);
+
+    task->getFirstScheduler()->registerTransactionTask(task);
+}
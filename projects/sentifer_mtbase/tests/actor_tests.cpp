@@ -0,0 +1,168 @@
+#include "doctest/doctest.h"
+
+#include <atomic>
+#include <vector>
+
+#include "test_environment.h"
+
+using namespace mtbase;
+using namespace mtbase::tests;
+
+namespace
+{
+    struct marker
+    {
+        int id{ 0 };
+        bool isYielding{ false };
+    };
+
+    struct recorder final :
+        public schedulable_actor<recorder, int, marker>
+    {
+        recorder(test_environment& env, const size_t mailboxCapacity) :
+            schedulable_actor{
+                env.resource, *env.flusher,
+                scheduler_restriction{ 1ms, 1ms, 100, 10 }, mailboxCapacity }
+        {}
+
+    public:
+        void handle(const int value)
+        {
+            seen.push_back(value);
+            ++cntHandled;
+        }
+
+        void handle(const marker& msg)
+        {
+            seen.push_back(-msg.id);
+            ++cntHandled;
+
+            // Registered by the running object, so it requests a yield.
+            if (msg.isYielding)
+                getScheduler()->registerContinuationTask([this]()
+                    {
+                        handledAtYield = cntHandled.load();
+                    });
+        }
+
+    public:
+        std::vector<int> seen;
+        std::atomic_int cntHandled{ 0 };
+        std::atomic_int handledAtYield{ -1 };
+    };
+
+    // Messages told from a task on the actor's own object stay queued until
+    // that task returns, so the test decides what the next drain sees.
+    template<class Func>
+    void run_on_actor(recorder& actor, Func&& func)
+    {
+        std::atomic_bool isDone{ false };
+        actor.getScheduler()->registerContinuationTask([&func, &isDone]()
+            {
+                func();
+                isDone = true;
+            });
+
+        REQUIRE(wait_until([&isDone]() { return isDone.load(); }));
+    }
+}
+
+TEST_CASE("tell fails on a full mailbox and succeeds once it drains")
+{
+    test_environment& env = test_environment::get();
+    recorder& actor = *new recorder{ env, 8 };
+
+    std::atomic_int cntAccepted{ 0 };
+    std::atomic_bool isRejected{ false };
+
+    run_on_actor(actor, [&]()
+        {
+            for (size_t i = 0; i < actor.getMailboxCapacity(); ++i)
+                cntAccepted += actor.tell(static_cast<int>(i)) ? 1 : 0;
+
+            isRejected = !actor.tell(-1);
+        });
+
+    CHECK(cntAccepted == 8);
+    CHECK(isRejected);
+
+    REQUIRE(wait_until([&actor]() { return actor.cntHandled == 8; }));
+    CHECK(actor.tell(8));
+    CHECK(wait_until([&actor]() { return actor.cntHandled == 9; }));
+}
+
+TEST_CASE("messages of every type are handled in the order they were told")
+{
+    constexpr int MESSAGE_COUNT = 500;
+
+    test_environment& env = test_environment::get();
+    recorder& actor = *new recorder{ env, 1024 };
+
+    for (int i = 1; i <= MESSAGE_COUNT; ++i)
+    {
+        const bool isTold = i % 3 == 0 ?
+            actor.tell(marker{ i }) :
+            actor.tell(i);
+        REQUIRE(isTold);
+    }
+
+    REQUIRE(wait_until([&actor]() { return actor.cntHandled == MESSAGE_COUNT; }));
+
+    for (int i = 1; i <= MESSAGE_COUNT; ++i)
+        CHECK(actor.seen[i - 1] == (i % 3 == 0 ? -i : i));
+}
+
+TEST_CASE("a drain hands the object back after a bounded number of messages")
+{
+    // MAX_DRAIN_COUNT in schedulable_actor.
+    static constexpr int MAX_DRAIN_COUNT = 64;
+    constexpr int MESSAGE_COUNT = MAX_DRAIN_COUNT * 3;
+
+    test_environment& env = test_environment::get();
+    recorder& actor = *new recorder{ env, 1024 };
+
+    std::atomic_int handledAtTask{ -1 };
+
+    run_on_actor(actor, [&]()
+        {
+            for (int i = 0; i < MESSAGE_COUNT; ++i)
+                static_cast<void>(actor.tell(i));
+
+            // Queued behind the drain, ahead of the one it rearms.
+            actor.getScheduler()->registerContinuationTask([&actor, &handledAtTask]()
+                {
+                    handledAtTask = actor.cntHandled.load();
+                });
+        });
+
+    REQUIRE(wait_until([&actor]() { return actor.cntHandled == MESSAGE_COUNT; }));
+    REQUIRE(wait_until([&handledAtTask]() { return handledAtTask >= 0; }));
+    CHECK(handledAtTask <= MAX_DRAIN_COUNT);
+}
+
+TEST_CASE("a drain stops at the message that requests a yield")
+{
+    constexpr int MESSAGE_COUNT = 10;
+    constexpr int YIELD_AT = 3;
+
+    test_environment& env = test_environment::get();
+    recorder& actor = *new recorder{ env, 1024 };
+
+    std::atomic_int cntTold{ 0 };
+
+    run_on_actor(actor, [&actor, &cntTold]()
+        {
+            for (int i = 0; i < MESSAGE_COUNT; ++i)
+            {
+                const bool isTold = i == YIELD_AT ?
+                    actor.tell(marker{ i, true }) :
+                    actor.tell(i);
+                cntTold += isTold ? 1 : 0;
+            }
+        });
+
+    REQUIRE(cntTold == MESSAGE_COUNT);
+    REQUIRE(wait_until([&actor]() { return actor.cntHandled == MESSAGE_COUNT; }));
+    REQUIRE(wait_until([&actor]() { return actor.handledAtYield >= 0; }));
+    CHECK(actor.handledAtYield == YIELD_AT + 1);
+}
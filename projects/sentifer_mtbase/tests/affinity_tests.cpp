@@ -0,0 +1,185 @@
+#include "doctest/doctest.h"
+
+#include <atomic>
+#include <limits>
+#include <thread>
+#include <vector>
+
+#include "test_environment.h"
+
+using namespace mtbase;
+using namespace mtbase::tests;
+
+namespace
+{
+    // Idle workers of this pool only ever spin, so they never starve and
+    // never steal from a shard that is within its affinity backlog.
+    struct spinning_pool final
+    {
+        explicit spinning_pool(const size_t workerCount) :
+            resource{ new std::pmr::synchronized_pool_resource{} }
+        {
+            std::vector<task_storage*> shardStorages;
+            for (size_t i = 0; i < workerCount; ++i)
+                shardStorages.push_back(new task_wait_free_deque<1024>{ resource });
+
+            flusher = new object_flush_scheduler{
+                resource, new task_wait_free_deque<1024>{ resource },
+                shardStorages, std::span<task_storage* const>{},
+                scheduler_restriction{ 1ms, 1ms, 100, 10 }, 8, 1ms };
+
+            for (size_t i = 0; i < workerCount; ++i)
+            {
+                test_worker* const worker = new test_worker{
+                    resource, *flusher, i,
+                    idle_policy{ std::numeric_limits<size_t>::max(), 0, 10ms } };
+                threads.emplace_back([worker]() { worker->flush(); });
+            }
+        }
+
+    public:
+        template<size_t Capacity>
+        [[nodiscard]]
+        schedulable_object<Capacity>& makeObject()
+        {
+            return *new schedulable_object<Capacity>{
+                resource, *flusher, scheduler_restriction{ 1ms, 1ms, 100, 10 } };
+        }
+
+        void stop()
+        {
+            flusher->requestStop();
+            for (std::thread& thread : threads)
+                thread.join();
+        }
+
+    public:
+        std::pmr::memory_resource* const resource;
+        object_flush_scheduler* flusher{ nullptr };
+        std::vector<std::thread> threads;
+    };
+
+    [[nodiscard]]
+    size_t current_worker_index()
+    {
+        return thread_local_scheduler::current()->getWorkerIndex();
+    }
+}
+
+TEST_CASE("an object that yields waits for its own worker rather than migrating")
+{
+    spinning_pool pool{ 2 };
+    auto& yielding = pool.makeObject<1024>();
+    auto& blocking = pool.makeObject<1024>();
+
+    std::atomic_size_t yieldedOn{ object_scheduler::NO_WORKER_INDEX };
+    std::atomic_size_t resumedOn{ object_scheduler::NO_WORKER_INDEX };
+
+    REQUIRE(yielding.scheduleFunc([&]()
+        {
+            yieldedOn = current_worker_index();
+
+            // Lands in this worker's next slot and keeps it busy while the
+            // yielded object sits in the queue.
+            static_cast<void>(blocking.scheduleFunc([]()
+                {
+                    std::this_thread::sleep_for(50ms);
+                }));
+
+            yield_with([&resumedOn]() { resumedOn = current_worker_index(); });
+        }));
+
+    REQUIRE(wait_until([&resumedOn]()
+        {
+            return resumedOn != object_scheduler::NO_WORKER_INDEX;
+        }));
+    CHECK(resumedOn == yieldedOn);
+
+    pool.stop();
+}
+
+TEST_CASE("an object that yields goes behind shared work that was already waiting")
+{
+    spinning_pool pool{ 1 };
+    auto& yielding = pool.makeObject<1024>();
+    auto& waiting = pool.makeObject<1024>();
+
+    std::atomic_bool isQueued{ false };
+    std::atomic_int order{ 0 };
+    std::atomic_int waitingAt{ -1 };
+    std::atomic_int resumedAt{ -1 };
+
+    REQUIRE(yielding.scheduleFunc([&]()
+        {
+            while (!isQueued)
+                std::this_thread::yield();
+
+            yield_with([&order, &resumedAt]() { resumedAt = order++; });
+        }));
+
+    // Never ran on a worker, so it goes to the shared storage.
+    REQUIRE(waiting.scheduleFunc([&order, &waitingAt]() { waitingAt = order++; }));
+    isQueued = true;
+
+    REQUIRE(wait_until([&order]() { return order == 2; }));
+    CHECK(waitingAt == 0);
+    CHECK(resumedAt == 1);
+
+    pool.stop();
+}
+
+TEST_CASE("an object activated from another worker goes back to its own worker")
+{
+    spinning_pool pool{ 2 };
+    auto& target = pool.makeObject<1024>();
+    auto& sender = pool.makeObject<1024>();
+
+    std::atomic_size_t targetOn{ object_scheduler::NO_WORKER_INDEX };
+    std::atomic_size_t senderOn{ object_scheduler::NO_WORKER_INDEX };
+    std::atomic_size_t receivedOn{ object_scheduler::NO_WORKER_INDEX };
+    std::atomic_bool gate{ false };
+
+    // The target holds its worker, so the fresh sender has to run on the
+    // other one.
+    REQUIRE(target.scheduleFunc([&targetOn, &gate]()
+        {
+            targetOn = current_worker_index();
+            while (!gate)
+                std::this_thread::yield();
+        }));
+    REQUIRE(wait_until([&targetOn]()
+        {
+            return targetOn != object_scheduler::NO_WORKER_INDEX;
+        }));
+
+    REQUIRE(sender.scheduleFunc([&senderOn]() { senderOn = current_worker_index(); }));
+    REQUIRE(wait_until([&senderOn]()
+        {
+            return senderOn != object_scheduler::NO_WORKER_INDEX;
+        }));
+    REQUIRE(senderOn != targetOn);
+
+    gate = true;
+
+    // Sent from the sender's worker, where the next slot would otherwise
+    // run it.
+    REQUIRE(sender.scheduleFunc([&target, &receivedOn]()
+        {
+            static_cast<void>(target.scheduleFunc([&receivedOn]()
+                {
+                    receivedOn = current_worker_index();
+                }));
+        }));
+    REQUIRE(wait_until([&receivedOn]()
+        {
+            return receivedOn != object_scheduler::NO_WORKER_INDEX;
+        }));
+
+    CHECK(receivedOn == targetOn);
+
+    const affinity_statistics stats = pool.flusher->getAffinityStatistics();
+    CHECK(stats.cntHit == 2);
+    CHECK(stats.cntMigrated == 0);
+
+    pool.stop();
+}
@@ -0,0 +1,122 @@
+#include "doctest/doctest.h"
+
+#include <atomic>
+#include <optional>
+#include <thread>
+
+#include "test_environment.h"
+
+using namespace mtbase;
+using namespace mtbase::tests;
+
+namespace
+{
+    struct store
+    {
+        [[nodiscard]]
+        int get(const int k)
+        {
+            return value * k;
+        }
+
+        void slow()
+        {
+            std::this_thread::sleep_for(30ms);
+        }
+
+    public:
+        int value{ 7 };
+    };
+}
+
+TEST_CASE("ask replies on the asking object with the target's result")
+{
+    constexpr int ASK_COUNT = 200;
+
+    test_environment& env = test_environment::get();
+    auto& asker = env.makeObject<1024>();
+    auto& target = env.makeObject<1024>();
+
+    store st;
+
+    // Replies are serialized on the asker, so plain ints are enough.
+    int sum = 0;
+    int cntReplied = 0;
+    std::atomic_bool isDone{ false };
+
+    for (int i = 0; i < ASK_COUNT; ++i)
+    {
+        asker.ask(target, &st, &store::get, [&](const int result)
+            {
+                sum += result;
+                if (++cntReplied == ASK_COUNT)
+                    isDone = true;
+            }, i);
+    }
+
+    REQUIRE(wait_until([&isDone]() { return isDone.load(); }));
+    CHECK(sum == 7 * (ASK_COUNT * (ASK_COUNT - 1) / 2));
+}
+
+TEST_CASE("askFor replies with the result when the target answers in time")
+{
+    test_environment& env = test_environment::get();
+    auto& asker = env.makeObject<1024>();
+    auto& target = env.makeObject<1024>();
+
+    store st;
+    std::atomic_int answered{ 0 };
+    std::atomic_int timedOut{ 0 };
+
+    for (int i = 0; i < 50; ++i)
+    {
+        asker.askFor(target, 500ms, &st, &store::get, [&](const std::optional<int> result)
+            {
+                if (result == 7)
+                    ++answered;
+                else
+                    ++timedOut;
+            }, 1);
+    }
+
+    REQUIRE(wait_until([&]() { return answered + timedOut == 50; }));
+    CHECK(answered == 50);
+}
+
+TEST_CASE("askFor replies exactly once when the target is too slow")
+{
+    test_environment& env = test_environment::get();
+    auto& asker = env.makeObject<1024>();
+    auto& target = env.makeObject<1024>();
+
+    store st;
+    std::atomic_bool isBusy{ false };
+    std::atomic_bool isDrained{ false };
+    std::atomic_int replies{ 0 };
+    std::atomic_int timeouts{ 0 };
+
+    REQUIRE(target.scheduleFunc([&]()
+        {
+            isBusy = true;
+            st.slow();
+        }));
+    REQUIRE(wait_until([&isBusy]() { return isBusy.load(); }));
+
+    asker.askFor(target, 5ms, &st, &store::slow, [&](const bool replied)
+        {
+            if (!replied)
+                ++timeouts;
+
+            ++replies;
+        });
+
+    REQUIRE(wait_until([&replies]() { return replies == 1; }));
+    CHECK(timeouts == 1);
+
+    // Let the target run the abandoned request, then check no late reply follows.
+    REQUIRE(target.scheduleFunc([&isDrained]() { isDrained = true; }));
+    REQUIRE(wait_until([&isDrained]() { return isDrained.load(); }));
+    std::this_thread::sleep_for(20ms);
+
+    CHECK(replies == 1);
+}
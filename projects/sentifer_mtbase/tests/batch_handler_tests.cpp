@@ -0,0 +1,190 @@
+#include "doctest/doctest.h"
+
+#include <atomic>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "test_environment.h"
+
+using namespace mtbase;
+using namespace mtbase::tests;
+
+namespace
+{
+    struct batch_log
+    {
+        std::vector<size_t> batchSizes;
+        std::vector<int> ids;
+        std::vector<std::string> names;
+        std::atomic_int cntRows{ 0 };
+    };
+
+    struct logging_handler
+    {
+        void operator()(std::span<int> ids, std::span<std::string> names)
+        {
+            log->batchSizes.push_back(ids.size());
+            log->ids.insert(log->ids.end(), ids.begin(), ids.end());
+            log->names.insert(log->names.end(), names.begin(), names.end());
+            log->cntRows += static_cast<int>(ids.size());
+        }
+
+    public:
+        batch_log* log;
+    };
+
+    using logging_batch = batch_handler<logging_handler, int, std::string>;
+
+    // Rows posted from a task on the target object wait for that task to
+    // return, so they all land in one batch.
+    template<class Func>
+    void run_on(object_scheduler* const sched, Func&& func)
+    {
+        std::atomic_bool isDone{ false };
+        sched->registerContinuationTask([&func, &isDone]()
+            {
+                func();
+                isDone = true;
+            });
+
+        REQUIRE(wait_until([&isDone]() { return isDone.load(); }));
+    }
+
+    struct fragile
+    {
+        fragile(const int v) :
+            value{ v }
+        {
+            if (v < 0)
+                throw std::invalid_argument{ "negative" };
+        }
+
+    public:
+        int value;
+    };
+}
+
+TEST_CASE("rows posted while the object is busy reach the handler as one ordered batch")
+{
+    constexpr int ROW_COUNT = 50;
+
+    test_environment& env = test_environment::get();
+    auto& obj = env.makeObject<1024>();
+
+    batch_log log;
+    logging_batch& batch = *new logging_batch{
+        env.resource, obj.getScheduler(), 64, logging_handler{ &log } };
+
+    std::atomic_int cntPosted{ 0 };
+    run_on(obj.getScheduler(), [&batch, &cntPosted]()
+        {
+            for (int i = 0; i < ROW_COUNT; ++i)
+                cntPosted += batch.post(i, std::to_string(i)) ? 1 : 0;
+        });
+
+    REQUIRE(cntPosted == ROW_COUNT);
+    REQUIRE(wait_until([&log]() { return log.cntRows == ROW_COUNT; }));
+
+    REQUIRE(log.batchSizes.size() == 1);
+    CHECK(log.batchSizes[0] == ROW_COUNT);
+    for (int i = 0; i < ROW_COUNT; ++i)
+    {
+        CHECK(log.ids[i] == i);
+        CHECK(log.names[i] == std::to_string(i));
+    }
+}
+
+TEST_CASE("post fails on a full ring and succeeds once a batch drains it")
+{
+    test_environment& env = test_environment::get();
+    auto& obj = env.makeObject<1024>();
+
+    batch_log log;
+    logging_batch& batch = *new logging_batch{
+        env.resource, obj.getScheduler(), 8, logging_handler{ &log } };
+
+    std::atomic_int cntPosted{ 0 };
+    std::atomic_bool isRejected{ false };
+    run_on(obj.getScheduler(), [&]()
+        {
+            for (size_t i = 0; i < batch.getCapacity(); ++i)
+                cntPosted += batch.post(static_cast<int>(i), "row") ? 1 : 0;
+
+            isRejected = !batch.post(-1, "overflow");
+        });
+
+    CHECK(cntPosted == 8);
+    CHECK(isRejected);
+
+    REQUIRE(wait_until([&log]() { return log.cntRows == 8; }));
+    CHECK(batch.post(8, "row"));
+    CHECK(wait_until([&log]() { return log.cntRows == 9; }));
+}
+
+TEST_CASE("a row that fails to construct is skipped and the rest keep their order")
+{
+    test_environment& env = test_environment::get();
+    auto& obj = env.makeObject<1024>();
+
+    std::vector<int> seen;
+    std::atomic_int cntRows{ 0 };
+    auto handler = [&seen, &cntRows](std::span<fragile> rows)
+    {
+        for (const fragile& row : rows)
+            seen.push_back(row.value);
+        cntRows += static_cast<int>(rows.size());
+    };
+
+    using fragile_batch = batch_handler<decltype(handler), fragile>;
+    fragile_batch& batch = *new fragile_batch{
+        env.resource, obj.getScheduler(), 16, std::move(handler) };
+
+    CHECK(batch.post(1));
+    CHECK_THROWS_AS(static_cast<void>(batch.post(-1)), std::invalid_argument);
+    CHECK(batch.post(2));
+
+    REQUIRE(wait_until([&cntRows]() { return cntRows == 2; }));
+    CHECK((seen == std::vector<int>{ 1, 2 }));
+
+    // The failed row's slot was handed back, so the whole ring is free.
+    std::atomic_int cntPosted{ 0 };
+    run_on(obj.getScheduler(), [&batch, &cntPosted]()
+        {
+            for (int i = 0; i < 16; ++i)
+                cntPosted += batch.post(i + 3) ? 1 : 0;
+        });
+
+    CHECK(cntPosted == 16);
+    CHECK(wait_until([&cntRows]() { return cntRows == 18; }));
+}
+
+TEST_CASE("a throwing handler still frees the ring for the next batch")
+{
+    throwing_pool& pool = *new throwing_pool{};
+    auto& obj = pool.makeObject<1024>();
+
+    std::atomic_int cntCalled{ 0 };
+    auto handler = [&cntCalled](std::span<int>)
+    {
+        ++cntCalled;
+        throw std::runtime_error{ "failed" };
+    };
+
+    using throwing_batch = batch_handler<decltype(handler), int>;
+    throwing_batch& batch = *new throwing_batch{
+        pool.resource, obj.getScheduler(), 8, std::move(handler) };
+
+    for (int i = 0; i < 8; ++i)
+        REQUIRE(batch.post(i));
+
+    REQUIRE(wait_until([&pool]() { return pool.cntUnwound == 1; }));
+    CHECK(cntCalled == 1);
+
+    // Every slot was released even though the handler never returned.
+    int cntPosted = 0;
+    while (cntPosted < 8 && batch.post(cntPosted))
+        ++cntPosted;
+    CHECK(cntPosted == 8);
+}
@@ -0,0 +1,71 @@
+#include "doctest/doctest.h"
+
+#include <atomic>
+#include <thread>
+
+#include "test_environment.h"
+
+using namespace mtbase;
+using namespace mtbase::tests;
+
+TEST_CASE("pending notifications under one key collapse into the latest")
+{
+    test_environment& env = test_environment::get();
+    auto& obj = env.makeObject<1024>();
+
+    std::atomic_bool gate{ false };
+    std::atomic_bool isBlocked{ false };
+    std::atomic_int runs{ 0 };
+    std::atomic_int last{ -1 };
+    std::atomic_int otherRuns{ 0 };
+
+    REQUIRE(obj.scheduleFunc([&]()
+        {
+            isBlocked = true;
+            while (!gate)
+                std::this_thread::yield();
+        }));
+    REQUIRE(wait_until([&isBlocked]() { return isBlocked.load(); }));
+
+    int accepted = 0;
+    for (int i = 0; i < 1000; ++i)
+    {
+        accepted += obj.scheduleCoalesced(7, [&runs, &last, i]()
+            {
+                ++runs;
+                last = i;
+            });
+    }
+    for (int i = 0; i < 10; ++i)
+        accepted += obj.scheduleCoalesced(8, [&otherRuns]() { ++otherRuns; });
+
+    // Replacing a pending notification still counts as accepted.
+    CHECK(accepted == 1010);
+
+    gate = true;
+
+    REQUIRE(wait_until([&]() { return runs == 1 && otherRuns == 1; }));
+
+    // Flush a plain task through so anything still queued would have run.
+    std::atomic_bool isDrained{ false };
+    REQUIRE(obj.scheduleFunc([&isDrained]() { isDrained = true; }));
+    REQUIRE(wait_until([&isDrained]() { return isDrained.load(); }));
+
+    CHECK(runs == 1);
+    CHECK(last == 999);
+    CHECK(otherRuns == 1);
+}
+
+TEST_CASE("a key queues again once its notification has run")
+{
+    test_environment& env = test_environment::get();
+    auto& obj = env.makeObject<1024>();
+
+    std::atomic_int runs{ 0 };
+
+    REQUIRE(obj.scheduleCoalesced(7, [&runs]() { ++runs; }));
+    REQUIRE(wait_until([&runs]() { return runs == 1; }));
+
+    REQUIRE(obj.scheduleCoalesced(7, [&runs]() { ++runs; }));
+    CHECK(wait_until([&runs]() { return runs == 2; }));
+}
@@ -0,0 +1,118 @@
+#include "doctest/doctest.h"
+
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+
+#include "test_environment.h"
+
+using namespace mtbase;
+using namespace mtbase::tests;
+
+namespace
+{
+    struct probe
+    {
+        std::atomic_bool isDone{ false };
+        std::atomic_bool isOnObject{ false };
+        std::atomic_bool isCaught{ false };
+        std::atomic_int result{ 0 };
+        std::chrono::steady_clock::duration waited{};
+    };
+
+    task<> resume_on(object_scheduler* const sched, probe* const p)
+    {
+        co_await schedule_awaiter{ *sched };
+
+        p->isOnObject = object_scheduler::current() == sched;
+        p->isDone = true;
+    }
+
+    task<> sleep_on(
+        object_scheduler* const sched,
+        const steady_tick after,
+        probe* const p)
+    {
+        const auto begin = std::chrono::steady_clock::now();
+
+        co_await after_awaiter{ *sched, after };
+
+        p->waited = std::chrono::steady_clock::now() - begin;
+        p->isOnObject = object_scheduler::current() == sched;
+        p->isDone = true;
+    }
+
+    task<int> add_on(object_scheduler* const sched, const int a, const int b)
+    {
+        co_await schedule_awaiter{ *sched };
+
+        co_return a + b;
+    }
+
+    task<int> fail_on(object_scheduler* const sched)
+    {
+        co_await schedule_awaiter{ *sched };
+
+        throw std::runtime_error{ "failed" };
+    }
+
+    task<> chain(object_scheduler* const a, object_scheduler* const b, probe* const p)
+    {
+        int sum = co_await add_on(a, 1, 2);
+        sum += co_await add_on(b, sum, 3);
+        p->result = sum;
+
+        try
+        {
+            static_cast<void>(co_await fail_on(a));
+        }
+        catch (const std::runtime_error&)
+        {
+            p->isCaught = true;
+        }
+
+        p->isOnObject = object_scheduler::current() == a;
+        p->isDone = true;
+    }
+}
+
+TEST_CASE("schedule_awaiter resumes the coroutine as a task of the object")
+{
+    test_environment& env = test_environment::get();
+    auto& obj = env.makeObject<1024>();
+
+    probe p;
+    resume_on(obj.getScheduler(), &p).detach();
+
+    REQUIRE(wait_until([&p]() { return p.isDone.load(); }));
+    CHECK(p.isOnObject);
+}
+
+TEST_CASE("after_awaiter resumes on the object once the delay passed")
+{
+    test_environment& env = test_environment::get();
+    auto& obj = env.makeObject<1024>();
+
+    probe p;
+    sleep_on(obj.getScheduler(), 20ms, &p).detach();
+
+    REQUIRE(wait_until([&p]() { return p.isDone.load(); }));
+    CHECK(p.isOnObject);
+    CHECK(p.waited >= 20ms);
+}
+
+TEST_CASE("awaited tasks hand back results and exceptions to the awaiting one")
+{
+    test_environment& env = test_environment::get();
+    auto& a = env.makeObject<1024>();
+    auto& b = env.makeObject<1024>();
+
+    probe p;
+    chain(a.getScheduler(), b.getScheduler(), &p).detach();
+
+    REQUIRE(wait_until([&p]() { return p.isDone.load(); }));
+    CHECK(p.result == 9);
+    CHECK(p.isCaught);
+    // The awaiting coroutine continues where the awaited one finished.
+    CHECK(p.isOnObject);
+}
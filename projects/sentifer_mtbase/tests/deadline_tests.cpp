@@ -0,0 +1,52 @@
+#include "doctest/doctest.h"
+
+#include <atomic>
+#include <thread>
+
+#include "test_environment.h"
+
+using namespace mtbase;
+using namespace mtbase::tests;
+
+TEST_CASE("objects kept late by a backlog do not starve a fresh object")
+{
+    // Twice the workers, so the deadline buckets never run dry on their own.
+    constexpr size_t LATE_OBJECT_COUNT = test_environment::WORKER_COUNT * 2;
+    constexpr int TASK_COUNT = 300;
+
+    test_environment& env = test_environment::get();
+
+    std::atomic_bool isStopped{ false };
+    std::atomic_int cntLeft{ static_cast<int>(LATE_OBJECT_COUNT) * TASK_COUNT };
+
+    // Every task outlasts the 1ms budget, so each flush expires and hands
+    // the object back to the flusher in the oldest deadline bucket.
+    for (size_t i = 0; i < LATE_OBJECT_COUNT; ++i)
+    {
+        auto& late = env.makeObject<1024>();
+        for (int k = 0; k < TASK_COUNT; ++k)
+        {
+            late.scheduleFunc([&isStopped, &cntLeft]()
+                {
+                    if (!isStopped)
+                        std::this_thread::sleep_for(2ms);
+                    --cntLeft;
+                });
+        }
+    }
+
+    std::this_thread::sleep_for(20ms);
+
+    auto& fresh = env.makeObject<1024>();
+    std::atomic_bool isRan{ false };
+    fresh.scheduleFunc([&isRan]() { isRan = true; });
+
+    const bool isRanEarly = wait_until([&isRan]() { return isRan.load(); }, 200ms);
+    const bool isBacklogLeft = cntLeft > 0;
+
+    isStopped = true;
+    REQUIRE(wait_until([&isRan, &cntLeft]() { return isRan && cntLeft == 0; }));
+
+    CHECK(isBacklogLeft);
+    CHECK(isRanEarly);
+}
@@ -0,0 +1,114 @@
+#include "doctest/doctest.h"
+
+#include <atomic>
+#include <memory_resource>
+#include <stdexcept>
+#include <thread>
+
+#include "test_environment.h"
+
+using namespace mtbase;
+using namespace mtbase::tests;
+
+namespace
+{
+    struct account
+    {
+        [[nodiscard]]
+        int read()
+        {
+            return balance;
+        }
+
+    public:
+        int balance{ 100 };
+    };
+}
+
+TEST_CASE("a future carries the result of a function or method task")
+{
+    test_environment& env = test_environment::get();
+    auto& obj = env.makeObject<1024>();
+
+    account acc;
+
+    auto tripled = obj.scheduleFuncWithFuture([](const int x) { return x * 3; }, 14);
+    auto balance = obj.scheduleMethodWithFuture(&acc, &account::read);
+
+    REQUIRE(wait_until([&]() { return tripled.isReady() && balance.isReady(); }));
+    CHECK(tripled.get() == 42);
+    CHECK(balance.get() == 100);
+}
+
+TEST_CASE("continuations run on their target object in order")
+{
+    test_environment& env = test_environment::get();
+    auto& a = env.makeObject<1024>();
+    auto& b = env.makeObject<1024>();
+
+    std::pmr::vector<future<int>> parts{ env.resource };
+    for (int i = 0; i < 100; ++i)
+        parts.push_back(a.scheduleFuncWithFuture([](const int x) { return x * 3; }, i));
+
+    auto summed = when_all(std::move(parts)).then(b,
+        [](std::pmr::vector<future<int>> ready)
+        {
+            int sum = 0;
+            for (auto& part : ready)
+                sum += part.get();
+
+            return sum;
+        });
+    auto chained = std::move(summed).then(a, [](const int sum) { return sum + 1; });
+
+    REQUIRE(wait_until([&chained]() { return chained.isReady(); }));
+    CHECK(chained.get() == 3 * 4950 + 1);
+}
+
+TEST_CASE("an exception skips the continuation and surfaces from get")
+{
+    test_environment& env = test_environment::get();
+    auto& a = env.makeObject<1024>();
+    auto& b = env.makeObject<1024>();
+
+    std::atomic_bool continued{ false };
+
+    auto failing = a.scheduleFuncWithFuture([]() -> int { throw std::runtime_error{ "failed" }; });
+    auto recovered = std::move(failing).then(b,
+        [&continued](int)
+        {
+            continued = true;
+            return 0;
+        });
+
+    REQUIRE(wait_until([&recovered]() { return recovered.isReady(); }));
+    CHECK_THROWS_AS(recovered.get(), std::runtime_error);
+    CHECK(!continued);
+}
+
+TEST_CASE("when_any reports the first future to become ready")
+{
+    test_environment& env = test_environment::get();
+    auto& a = env.makeObject<1024>();
+    auto& b = env.makeObject<1024>();
+
+    std::atomic_bool gate{ false };
+
+    std::pmr::vector<future<void>> racing{ env.resource };
+    racing.push_back(a.scheduleFuncWithFuture([&gate]()
+        {
+            while (!gate)
+                std::this_thread::yield();
+        }));
+    racing.push_back(b.scheduleFuncWithFuture([]() {}));
+
+    auto first = when_any(std::move(racing));
+
+    REQUIRE(wait_until([&first]() { return first.isReady(); }));
+
+    when_any_result<void> result = first.get();
+    CHECK(result.index == 1);
+
+    gate = true;
+    CHECK(wait_until([&result]() { return result.futures[0].isReady(); }));
+}
@@ -0,0 +1,84 @@
+#include "doctest/doctest.h"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "test_environment.h"
+
+using namespace mtbase;
+using namespace mtbase::tests;
+
+TEST_CASE("tasks injected from outside the pool all run on workers")
+{
+    constexpr int PRODUCER_COUNT = 3;
+    constexpr int TASK_COUNT = 5000;
+
+    test_environment& env = test_environment::get();
+
+    std::atomic_int ran{ 0 };
+    std::atomic_int offWorker{ 0 };
+
+    std::vector<std::thread> producers;
+    for (int p = 0; p < PRODUCER_COUNT; ++p)
+    {
+        producers.emplace_back([&]()
+            {
+                for (int i = 0; i < TASK_COUNT; ++i)
+                {
+                    env.flusher->injectFuncTask([&]()
+                        {
+                            if (thread_local_scheduler::current() == nullptr)
+                                ++offWorker;
+
+                            ++ran;
+                        });
+                }
+            });
+    }
+
+    for (auto& producer : producers)
+        producer.join();
+
+    REQUIRE(wait_until([&ran]() { return ran == PRODUCER_COUNT * TASK_COUNT; }));
+    CHECK(offWorker == 0);
+}
+
+TEST_CASE("a worker flooding its own storage loses no task")
+{
+    // Several times the capacity of a worker's local deque.
+    constexpr int TASK_COUNT = 5000;
+
+    test_environment& env = test_environment::get();
+
+    std::atomic_int ran{ 0 };
+
+    env.flusher->injectFuncTask([&ran]()
+        {
+            thread_local_scheduler* const worker = thread_local_scheduler::current();
+
+            for (int i = 0; i < TASK_COUNT; ++i)
+                static_cast<void>(worker->registerFuncTask([&ran]() { ++ran; }));
+        });
+
+    CHECK(wait_until([&ran]() { return ran == TASK_COUNT; }));
+}
+
+TEST_CASE("objects keep flowing while the injector is busy")
+{
+    constexpr int TASK_COUNT = 5000;
+
+    test_environment& env = test_environment::get();
+    auto& obj = env.makeObject<8192>();
+
+    std::atomic_int injectedRan{ 0 };
+    std::atomic_int objectRan{ 0 };
+
+    for (int i = 0; i < TASK_COUNT; ++i)
+    {
+        env.flusher->injectFuncTask([&injectedRan]() { ++injectedRan; });
+        REQUIRE(obj.scheduleFunc([&objectRan]() { ++objectRan; }));
+    }
+
+    REQUIRE(wait_until([&]() { return injectedRan == TASK_COUNT && objectRan == TASK_COUNT; }));
+}
@@ -0,0 +1,178 @@
+#include "doctest/doctest.h"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "test_environment.h"
+
+using namespace mtbase;
+using namespace mtbase::tests;
+
+TEST_CASE("an idle object is scheduled by its first task and goes idle again after draining")
+{
+    test_environment& env = test_environment::get();
+    auto& obj = env.makeObject<1024>();
+
+    std::atomic_int ran{ 0 };
+
+    REQUIRE(obj.scheduleFunc([&ran]() { ++ran; }));
+    REQUIRE(wait_until([&ran]() { return ran == 1; }));
+
+    // Let the worker drain the object and put it back to idle, then make sure
+    // the next enqueue activates it again instead of being stranded.
+    std::this_thread::sleep_for(20ms);
+
+    REQUIRE(obj.scheduleFunc([&ran]() { ++ran; }));
+    CHECK(wait_until([&ran]() { return ran == 2; }));
+}
+
+TEST_CASE("a running object never executes two of its tasks at once")
+{
+    constexpr int PRODUCER_COUNT = 4;
+    constexpr int TASK_COUNT = 2000;
+
+    test_environment& env = test_environment::get();
+    auto& obj = env.makeObject<4096>();
+
+    std::atomic_int inFlight{ 0 };
+    std::atomic_int overlaps{ 0 };
+    std::atomic_int ran{ 0 };
+
+    std::vector<std::thread> producers;
+    for (int p = 0; p < PRODUCER_COUNT; ++p)
+    {
+        producers.emplace_back([&]()
+            {
+                for (int i = 0; i < TASK_COUNT; ++i)
+                {
+                    while (!obj.scheduleFunc([&]()
+                        {
+                            if (inFlight.fetch_add(1) != 0)
+                                ++overlaps;
+
+                            inFlight.fetch_sub(1);
+                            ++ran;
+                        }))
+                        std::this_thread::yield();
+                }
+            });
+    }
+
+    for (auto& producer : producers)
+        producer.join();
+
+    REQUIRE(wait_until([&ran]() { return ran == PRODUCER_COUNT * TASK_COUNT; }));
+    CHECK(overlaps == 0);
+}
+
+TEST_CASE("a task enqueued by the running object reschedules it instead of being lost")
+{
+    constexpr int CHAIN_LENGTH = 500;
+
+    test_environment& env = test_environment::get();
+    auto& obj = env.makeObject<1024>();
+
+    std::vector<int> seen;
+    std::atomic_int ran{ 0 };
+
+    struct chain_t
+    {
+        schedulable_object<1024>& obj;
+        std::vector<int>& seen;
+        std::atomic_int& ran;
+
+        void step(const int i)
+        {
+            seen.push_back(i);
+            ++ran;
+
+            if (i + 1 < CHAIN_LENGTH)
+                static_cast<void>(obj.scheduleMethod(this, &chain_t::step, i + 1));
+        }
+    } chain{ obj, seen, ran };
+
+    REQUIRE(obj.scheduleMethod(&chain, &chain_t::step, 0));
+    REQUIRE(wait_until([&ran]() { return ran == CHAIN_LENGTH; }));
+
+    for (int i = 0; i < CHAIN_LENGTH; ++i)
+        CHECK(seen[i] == i);
+}
+
+TEST_CASE("objects handed between workers run every task exactly once")
+{
+    constexpr int OBJECT_COUNT = 8;
+    constexpr int TASK_COUNT = 8000;
+
+    test_environment& env = test_environment::get();
+
+    std::vector<schedulable_object<4096>*> objs;
+    for (int i = 0; i < OBJECT_COUNT; ++i)
+        objs.push_back(&env.makeObject<4096>());
+
+    std::atomic_int ran{ 0 };
+    std::vector<std::thread> producers;
+    for (int p = 0; p < 4; ++p)
+    {
+        producers.emplace_back([&, p]()
+            {
+                for (int i = 0; i < TASK_COUNT / 4; ++i)
+                    while (!objs[(p + i) % OBJECT_COUNT]->scheduleFunc([&ran]() { ++ran; }))
+                        std::this_thread::yield();
+            });
+    }
+
+    for (auto& producer : producers)
+        producer.join();
+
+    CHECK(wait_until([&ran]() { return ran == TASK_COUNT; }));
+}
+
+TEST_CASE("an object activated while it runs still drains back to idle")
+{
+    test_environment& env = test_environment::get();
+    auto& obj = env.makeObject<1024>();
+
+    std::atomic_bool gate{ false };
+    std::atomic_bool isBlocked{ false };
+    std::atomic_int ran{ 0 };
+
+    REQUIRE(obj.scheduleFunc([&]()
+        {
+            isBlocked = true;
+            while (!gate)
+                std::this_thread::yield();
+
+            ++ran;
+        }));
+    REQUIRE(wait_until([&isBlocked]() { return isBlocked.load(); }));
+
+    // Activates the running object, so it drains with SCHEDULED still set.
+    REQUIRE(obj.scheduleFunc([&ran]() { ++ran; }));
+    gate = true;
+
+    REQUIRE(wait_until([&ran]() { return ran == 2; }));
+
+    // Only an idle object is dispatched inline on the calling worker.
+    std::atomic_int attempts{ 0 };
+    std::atomic_int dispatched{ 0 };
+    std::atomic_bool isInline{ false };
+    CHECK(wait_until([&]()
+        {
+            std::atomic_bool isDone{ false };
+
+            ++attempts;
+            env.flusher->injectFuncTask([&]()
+                {
+                    const int before = dispatched;
+                    obj.dispatchFunc([&dispatched]() { ++dispatched; });
+
+                    isInline = (dispatched == before + 1);
+                    isDone = true;
+                });
+
+            return wait_until([&isDone]() { return isDone.load(); }) && isInline;
+        }));
+
+    REQUIRE(wait_until([&]() { return dispatched == attempts; }));
+}
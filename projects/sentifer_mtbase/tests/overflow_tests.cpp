@@ -0,0 +1,265 @@
+#include "doctest/doctest.h"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "test_environment.h"
+
+using namespace mtbase;
+using namespace mtbase::tests;
+
+namespace
+{
+    // Parks the object on a task that spins until the gate opens, so the
+    // tasks enqueued meanwhile pile up in its storage.
+    template<size_t Capacity>
+    void block_object(schedulable_object<Capacity>& obj, std::atomic_bool& gate)
+    {
+        std::atomic_bool isBlocked{ false };
+
+        REQUIRE(obj.scheduleFunc([&gate, &isBlocked]()
+            {
+                isBlocked = true;
+                while (!gate)
+                    std::this_thread::yield();
+            }));
+        REQUIRE(wait_until([&isBlocked]() { return isBlocked.load(); }));
+    }
+}
+
+TEST_CASE("REJECT refuses tasks once the object's storage is full")
+{
+    test_environment& env = test_environment::get();
+    auto& obj = env.makeObject<64>();
+
+    std::atomic_bool gate{ false };
+    std::atomic_int ran{ 0 };
+    int accepted = 0;
+    int rejected = 0;
+
+    block_object(obj, gate);
+
+    for (int i = 0; i < 200; ++i)
+        ++(obj.scheduleFunc([&ran]() { ++ran; }) ? accepted : rejected);
+
+    gate = true;
+
+    CHECK(rejected > 0);
+    CHECK(accepted > 0);
+    REQUIRE(wait_until([&]() { return ran == accepted; }));
+
+    std::this_thread::sleep_for(10ms);
+    CHECK(ran == accepted);
+}
+
+TEST_CASE("SPILL accepts every task and keeps their order")
+{
+    constexpr int TASK_COUNT = 1000;
+
+    test_environment& env = test_environment::get();
+    auto& obj = env.makeObject<64>();
+    obj.setOverflowPolicy(overflow_policy::SPILL);
+
+    std::atomic_bool gate{ false };
+    std::atomic_int ran{ 0 };
+    std::vector<int> seen;
+
+    block_object(obj, gate);
+
+    bool isAllAccepted = true;
+    for (int i = 0; i < TASK_COUNT; ++i)
+    {
+        isAllAccepted &= obj.scheduleFunc([&seen, &ran, i]()
+            {
+                seen.push_back(i);
+                ++ran;
+            });
+    }
+
+    gate = true;
+
+    CHECK(isAllAccepted);
+    REQUIRE(wait_until([&ran]() { return ran == TASK_COUNT; }));
+
+    for (int i = 0; i < TASK_COUNT; ++i)
+        CHECK(seen[i] == i);
+}
+
+TEST_CASE("SPILL runs cut-in tasks that overflowed ahead of the full storage")
+{
+    constexpr int TASK_COUNT = 100;
+
+    test_environment& env = test_environment::get();
+    auto& obj = env.makeObject<64>();
+    obj.setOverflowPolicy(overflow_policy::SPILL);
+
+    std::atomic_bool gate{ false };
+    std::atomic_int ran{ 0 };
+    std::vector<int> seen;
+
+    block_object(obj, gate);
+
+    for (int i = 0; i < TASK_COUNT; ++i)
+    {
+        REQUIRE(obj.scheduleFunc([&seen, &ran, i]()
+            {
+                seen.push_back(i);
+                ++ran;
+            }));
+    }
+
+    // Both spill, the newer one ahead of the older.
+    for (const int id : { -1, -2 })
+    {
+        REQUIRE(obj.scheduleFuncCuttingIn([&seen, &ran, id]()
+            {
+                seen.push_back(id);
+                ++ran;
+            }));
+    }
+
+    gate = true;
+
+    REQUIRE(wait_until([&ran]() { return ran == TASK_COUNT + 2; }));
+
+    CHECK(seen[0] == -2);
+    CHECK(seen[1] == -1);
+    for (int i = 0; i < TASK_COUNT; ++i)
+        CHECK(seen[i + 2] == i);
+}
+
+TEST_CASE("BLOCK holds the producer until the object frees space")
+{
+    constexpr int TASK_COUNT = 5000;
+
+    test_environment& env = test_environment::get();
+    auto& obj = env.makeObject<64>();
+    obj.setOverflowPolicy(overflow_policy::BLOCK);
+
+    std::atomic_int ran{ 0 };
+    std::vector<int> seen;
+
+    bool isAllAccepted = true;
+    for (int i = 0; i < TASK_COUNT; ++i)
+    {
+        isAllAccepted &= obj.scheduleFunc([&seen, &ran, i]()
+            {
+                seen.push_back(i);
+                ++ran;
+            });
+    }
+
+    CHECK(isAllAccepted);
+    REQUIRE(wait_until([&ran]() { return ran == TASK_COUNT; }));
+
+    for (int i = 0; i < TASK_COUNT; ++i)
+        CHECK(seen[i] == i);
+}
+
+TEST_CASE("an object posting to itself buffers past its storage, up to a bound")
+{
+    // Below and far above MAX_OWNED_TASK_COUNT in object_scheduler.
+    constexpr int BUFFERED_COUNT = 200;
+    constexpr int FLOOD_COUNT = 2000;
+
+    test_environment& env = test_environment::get();
+    auto& obj = env.makeObject<64>();
+
+    for (const int taskCount : { BUFFERED_COUNT, FLOOD_COUNT })
+    {
+        std::atomic_int accepted{ -1 };
+        std::atomic_int ran{ 0 };
+        std::vector<int> seen;
+
+        REQUIRE(obj.scheduleFunc([&obj, &accepted, &ran, &seen, taskCount]()
+            {
+                int cntAccepted = 0;
+                for (int i = 0; i < taskCount; ++i)
+                {
+                    cntAccepted += obj.scheduleFunc([&seen, &ran, i]()
+                        {
+                            seen.push_back(i);
+                            ++ran;
+                        }) ? 1 : 0;
+                }
+
+                accepted = cntAccepted;
+            }));
+
+        REQUIRE(wait_until([&]() { return accepted >= 0 && ran == accepted; }));
+
+        if (taskCount == BUFFERED_COUNT)
+            CHECK(accepted == BUFFERED_COUNT);
+        else
+            CHECK(accepted < FLOOD_COUNT);
+
+        for (size_t i = 1; i < seen.size(); ++i)
+            CHECK(seen[i - 1] < seen[i]);
+    }
+}
+
+TEST_CASE("SPILL keeps the order of tasks an object posts to itself")
+{
+    constexpr int TASK_COUNT = 2000;
+
+    test_environment& env = test_environment::get();
+    auto& obj = env.makeObject<64>();
+    obj.setOverflowPolicy(overflow_policy::SPILL);
+
+    std::atomic_bool isAllAccepted{ false };
+    std::atomic_int ran{ 0 };
+    std::vector<int> seen;
+
+    REQUIRE(obj.scheduleFunc([&]()
+        {
+            bool isAccepted = true;
+            for (int i = 0; i < TASK_COUNT; ++i)
+            {
+                isAccepted &= obj.scheduleFunc([&seen, &ran, i]()
+                    {
+                        seen.push_back(i);
+                        ++ran;
+                    });
+            }
+
+            isAllAccepted = isAccepted;
+        }));
+
+    REQUIRE(wait_until([&ran]() { return ran == TASK_COUNT; }));
+    CHECK(isAllAccepted);
+
+    for (int i = 0; i < TASK_COUNT; ++i)
+        CHECK(seen[i] == i);
+}
+
+TEST_CASE("tasks an object posted to itself outlive a flush that expires")
+{
+    constexpr int TASK_COUNT = 10;
+
+    test_environment& env = test_environment::get();
+    auto& obj = env.makeObject<64>();
+
+    std::atomic_int ran{ 0 };
+    std::vector<int> seen;
+
+    REQUIRE(obj.scheduleFunc([&]()
+        {
+            for (int i = 0; i < TASK_COUNT; ++i)
+            {
+                static_cast<void>(obj.scheduleFunc([&seen, &ran, i]()
+                    {
+                        seen.push_back(i);
+                        ++ran;
+                    }));
+            }
+
+            // Past the 1ms budget, so the flush ends with them still buffered.
+            std::this_thread::sleep_for(3ms);
+        }));
+
+    REQUIRE(wait_until([&ran]() { return ran == TASK_COUNT; }));
+
+    for (int i = 0; i < TASK_COUNT; ++i)
+        CHECK(seen[i] == i);
+}
@@ -0,0 +1,130 @@
+#include "doctest/doctest.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <numeric>
+#include <random>
+#include <vector>
+
+#include "test_environment.h"
+
+using namespace mtbase;
+using namespace mtbase::tests;
+
+namespace
+{
+    // get_chunk_grain for 8-byte elements.
+    constexpr size_t GRAIN = PARALLEL_CHUNK_BYTES / sizeof(uint64_t);
+
+    constexpr size_t SIZES[] = {
+        0, 1, GRAIN - 1, GRAIN, GRAIN + 1, GRAIN * 3 + 5, GRAIN * 16 };
+
+    [[nodiscard]]
+    std::vector<uint64_t> make_input(const size_t size, const uint64_t bound)
+    {
+        std::mt19937_64 random{ size };
+        std::vector<uint64_t> values(size);
+        for (uint64_t& value : values)
+            value = random() % bound;
+
+        return values;
+    }
+
+    [[nodiscard]]
+    task_group make_group()
+    {
+        test_environment& env = test_environment::get();
+
+        return task_group{ env.resource, *env.flusher };
+    }
+}
+
+TEST_CASE("parallel sort matches std::sort")
+{
+    for (const size_t size : SIZES)
+    {
+        CAPTURE(size);
+
+        // Few distinct values, so partitions see long runs of equal keys.
+        const std::vector<uint64_t> input = make_input(size, 100);
+        task_group group = make_group();
+
+        std::vector<uint64_t> actual = input;
+        std::vector<uint64_t> expected = input;
+        mtbase::sort(group, actual.begin(), actual.end());
+        std::sort(expected.begin(), expected.end());
+        CHECK(actual == expected);
+
+        actual = input;
+        expected = input;
+        mtbase::sort(group, actual.begin(), actual.end(), std::greater<>{});
+        std::sort(expected.begin(), expected.end(), std::greater<>{});
+        CHECK(actual == expected);
+    }
+}
+
+TEST_CASE("parallel reduce matches std::accumulate")
+{
+    for (const size_t size : SIZES)
+    {
+        CAPTURE(size);
+
+        const std::vector<uint64_t> input = make_input(size, UINT64_MAX);
+        task_group group = make_group();
+
+        CHECK(mtbase::reduce(group, input.begin(), input.end(), uint64_t{ 7 }) ==
+            std::accumulate(input.begin(), input.end(), uint64_t{ 7 }));
+        CHECK(mtbase::reduce(group, input.begin(), input.end(), uint64_t{ 0 },
+            [](const uint64_t a, const uint64_t b) { return a ^ b; }) ==
+            std::accumulate(input.begin(), input.end(), uint64_t{ 0 },
+                [](const uint64_t a, const uint64_t b) { return a ^ b; }));
+    }
+}
+
+TEST_CASE("parallel inclusive_scan matches std::inclusive_scan")
+{
+    for (const size_t size : SIZES)
+    {
+        CAPTURE(size);
+
+        const std::vector<uint64_t> input = make_input(size, UINT64_MAX);
+        task_group group = make_group();
+
+        std::vector<uint64_t> actual(size);
+        std::vector<uint64_t> expected(size);
+        const auto actualEnd = mtbase::inclusive_scan(
+            group, input.begin(), input.end(), actual.begin());
+        std::inclusive_scan(input.begin(), input.end(), expected.begin());
+
+        CHECK(actualEnd == actual.end());
+        CHECK(actual == expected);
+    }
+}
+
+TEST_CASE("parallel transform and for_each match their serial versions")
+{
+    for (const size_t size : SIZES)
+    {
+        CAPTURE(size);
+
+        const std::vector<uint64_t> input = make_input(size, UINT64_MAX);
+        task_group group = make_group();
+
+        std::vector<uint64_t> actual(size);
+        std::vector<uint64_t> expected(size);
+        const auto square = [](const uint64_t x) { return x * x + 1; };
+        const auto actualEnd = mtbase::transform(
+            group, input.begin(), input.end(), actual.begin(), square);
+        std::transform(input.begin(), input.end(), expected.begin(), square);
+
+        CHECK(actualEnd == actual.end());
+        CHECK(actual == expected);
+
+        const auto increment = [](uint64_t& x) { x += 3; };
+        mtbase::for_each(group, actual.begin(), actual.end(), increment);
+        std::for_each(expected.begin(), expected.end(), increment);
+
+        CHECK(actual == expected);
+    }
+}
@@ -0,0 +1,148 @@
+#include "doctest/doctest.h"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "test_environment.h"
+
+using namespace mtbase;
+using namespace mtbase::tests;
+
+namespace
+{
+    constexpr int BULK = 0;
+    constexpr int URGENT = 1;
+
+    // Parks the object on a task that spins until the gate opens, so the
+    // tasks enqueued meanwhile pile up in its lanes.
+    template<size_t Capacity>
+    void block_object(schedulable_object<Capacity>& obj, std::atomic_bool& gate)
+    {
+        std::atomic_bool isBlocked{ false };
+
+        REQUIRE(obj.scheduleFunc([&gate, &isBlocked]()
+            {
+                isBlocked = true;
+                while (!gate)
+                    std::this_thread::yield();
+            }));
+        REQUIRE(wait_until([&isBlocked]() { return isBlocked.load(); }));
+    }
+}
+
+TEST_CASE("a heavier lane overtakes bulk work in proportion to its weight")
+{
+    constexpr int TASK_COUNT = 40;
+    constexpr size_t URGENT_WEIGHT = 3;
+
+    test_environment& env = test_environment::get();
+    auto& obj = env.makeObject<1024>();
+    const size_t urgentLane = obj.addPriorityLane(URGENT_WEIGHT);
+
+    std::atomic_bool gate{ false };
+    std::atomic_int ran{ 0 };
+    std::vector<int> seen;
+
+    block_object(obj, gate);
+
+    for (int i = 0; i < TASK_COUNT; ++i)
+    {
+        REQUIRE(obj.scheduleFunc([&seen, &ran]()
+            {
+                seen.push_back(BULK);
+                ++ran;
+            }));
+        REQUIRE(obj.scheduleFuncOnLane(urgentLane, [&seen, &ran]()
+            {
+                seen.push_back(URGENT);
+                ++ran;
+            }));
+    }
+
+    gate = true;
+
+    REQUIRE(wait_until([&ran]() { return ran == TASK_COUNT * 2; }));
+
+    // While both lanes are busy, every round of four pops takes three
+    // urgent tasks and still one bulk task.
+    for (int round = 0; round < TASK_COUNT / static_cast<int>(URGENT_WEIGHT); ++round)
+    {
+        int cntUrgent = 0;
+        for (int i = round * 4; i < round * 4 + 4; ++i)
+            cntUrgent += seen[i] == URGENT ? 1 : 0;
+
+        CHECK(cntUrgent == static_cast<int>(URGENT_WEIGHT));
+    }
+}
+
+TEST_CASE("an idle lane leaves the others to run in order")
+{
+    constexpr int TASK_COUNT = 50;
+
+    test_environment& env = test_environment::get();
+    auto& obj = env.makeObject<1024>();
+    const size_t urgentLane = obj.addPriorityLane(4);
+
+    std::atomic_bool gate{ false };
+    std::atomic_int ran{ 0 };
+    std::vector<int> seen;
+
+    block_object(obj, gate);
+
+    for (int i = 0; i < TASK_COUNT; ++i)
+    {
+        REQUIRE(obj.scheduleFuncOnLane(urgentLane, [&seen, &ran, i]()
+            {
+                seen.push_back(i);
+                ++ran;
+            }));
+    }
+
+    gate = true;
+
+    REQUIRE(wait_until([&ran]() { return ran == TASK_COUNT; }));
+
+    for (int i = 0; i < TASK_COUNT; ++i)
+        CHECK(seen[i] == i);
+}
+
+TEST_CASE("cut-in tasks overtake every lane")
+{
+    constexpr int TASK_COUNT = 20;
+
+    test_environment& env = test_environment::get();
+    auto& obj = env.makeObject<1024>();
+    const size_t urgentLane = obj.addPriorityLane(8);
+
+    std::atomic_bool gate{ false };
+    std::atomic_int ran{ 0 };
+    std::vector<int> seen;
+
+    block_object(obj, gate);
+
+    for (int i = 0; i < TASK_COUNT; ++i)
+    {
+        REQUIRE(obj.scheduleFunc([&seen, &ran]()
+            {
+                seen.push_back(BULK);
+                ++ran;
+            }));
+        REQUIRE(obj.scheduleFuncOnLane(urgentLane, [&seen, &ran]()
+            {
+                seen.push_back(URGENT);
+                ++ran;
+            }));
+    }
+
+    REQUIRE(obj.scheduleFuncCuttingIn([&seen, &ran]()
+        {
+            seen.push_back(-1);
+            ++ran;
+        }));
+
+    gate = true;
+
+    REQUIRE(wait_until([&ran]() { return ran == TASK_COUNT * 2 + 1; }));
+    CHECK(seen[0] == -1);
+}
@@ -0,0 +1,152 @@
+#include "doctest/doctest.h"
+
+#include <atomic>
+#include <thread>
+
+#include "test_environment.h"
+
+using namespace mtbase;
+using namespace mtbase::tests;
+
+namespace
+{
+    struct read_tracker
+    {
+        void enter()
+        {
+            const int now = ++active;
+
+            int peak = maxActive.load();
+            while (now > peak && !maxActive.compare_exchange_weak(peak, now));
+        }
+
+        void leave()
+        {
+            --active;
+        }
+
+    public:
+        std::atomic_int active{ 0 };
+        std::atomic_int maxActive{ 0 };
+    };
+}
+
+TEST_CASE("reads share the object and a write splits them in order")
+{
+    constexpr int READ_COUNT = 16;
+
+    test_environment& env = test_environment::get();
+    auto& obj = env.makeObject<1024>();
+
+    read_tracker tracker;
+    int value = 0;
+    std::atomic_int reads{ 0 };
+    std::atomic_int staleReads{ 0 };
+    std::atomic_int writerOverlaps{ 0 };
+
+    auto reader = [&](const int expected)
+    {
+        tracker.enter();
+        std::this_thread::sleep_for(3ms);
+        if (value != expected)
+            ++staleReads;
+        tracker.leave();
+
+        ++reads;
+    };
+
+    for (int i = 0; i < READ_COUNT; ++i)
+        REQUIRE(obj.scheduleRead(reader, 0));
+    REQUIRE(obj.scheduleWrite([&]()
+        {
+            if (tracker.active != 0)
+                ++writerOverlaps;
+
+            value = 1;
+        }));
+    for (int i = 0; i < READ_COUNT; ++i)
+        REQUIRE(obj.scheduleRead(reader, 1));
+
+    REQUIRE(wait_until([&reads]() { return reads == READ_COUNT * 2; }));
+    CHECK(staleReads == 0);
+    CHECK(writerOverlaps == 0);
+    CHECK(tracker.maxActive >= 2);
+}
+
+TEST_CASE("writes never overlap reads under a mixed load")
+{
+    constexpr int TASK_COUNT = 3000;
+
+    test_environment& env = test_environment::get();
+    auto& obj = env.makeObject<4096>();
+
+    std::atomic_int activeReads{ 0 };
+    std::atomic_int activeWrites{ 0 };
+    std::atomic_int overlaps{ 0 };
+    std::atomic_int ran{ 0 };
+
+    for (int i = 0; i < TASK_COUNT; ++i)
+    {
+        if (i % 10 == 0)
+        {
+            while (!obj.scheduleWrite([&]()
+                {
+                    if (activeWrites.fetch_add(1) != 0 || activeReads != 0)
+                        ++overlaps;
+
+                    activeWrites.fetch_sub(1);
+                    ++ran;
+                }))
+                std::this_thread::yield();
+        }
+        else
+        {
+            while (!obj.scheduleRead([&]()
+                {
+                    activeReads.fetch_add(1);
+                    if (activeWrites != 0)
+                        ++overlaps;
+
+                    activeReads.fetch_sub(1);
+                    ++ran;
+                }))
+                std::this_thread::yield();
+        }
+    }
+
+    REQUIRE(wait_until([&ran]() { return ran == TASK_COUNT; }));
+    CHECK(overlaps == 0);
+}
+
+TEST_CASE("a dispatch while reads are in flight waits for them")
+{
+    test_environment& env = test_environment::get();
+    auto& obj = env.makeObject<1024>();
+
+    std::atomic_bool isReading{ false };
+    std::atomic_bool isReadDone{ false };
+    std::atomic_int overlaps{ 0 };
+    std::atomic_int dispatched{ 0 };
+
+    REQUIRE(obj.scheduleRead([&]()
+        {
+            isReading = true;
+            std::this_thread::sleep_for(10ms);
+            isReadDone = true;
+        }));
+    REQUIRE(wait_until([&isReading]() { return isReading.load(); }));
+
+    env.flusher->injectFuncTask([&]()
+        {
+            obj.dispatchFunc([&]()
+                {
+                    if (!isReadDone)
+                        ++overlaps;
+
+                    ++dispatched;
+                });
+        });
+
+    REQUIRE(wait_until([&dispatched]() { return dispatched == 1; }));
+    CHECK(overlaps == 0);
+}
@@ -0,0 +1,96 @@
+#include "doctest/doctest.h"
+
+#include "test_environment.h"
+
+using namespace mtbase;
+using namespace mtbase::tests;
+
+namespace
+{
+    constexpr size_t MIN_FLUSH_COUNT = 4;
+    constexpr size_t MAX_FLUSH_COUNT = 256;
+    constexpr size_t MIN_FLUSH_COUNT_AT_ONCE = 2;
+    constexpr size_t MAX_FLUSH_COUNT_AT_ONCE = 64;
+
+    [[nodiscard]]
+    restriction_controller make_controller()
+    {
+        return restriction_controller{
+            scheduler_restriction{ 1ms, 1ms, 100, 10 },
+            adaptive_policy{
+                10ms,
+                scheduler_restriction{ 100us, 100us, MIN_FLUSH_COUNT, MIN_FLUSH_COUNT_AT_ONCE },
+                scheduler_restriction{ 2ms, 2ms, MAX_FLUSH_COUNT, MAX_FLUSH_COUNT_AT_ONCE } } };
+    }
+
+    // One flush of `cntExecuted` tasks costing `tickTask` each.
+    void record(
+        restriction_controller& controller,
+        const steady_tick tickTask,
+        const size_t cntExecuted)
+    {
+        controller.recordFlushing(
+            steady_tick{}, tickTask * static_cast<steady_tick::rep>(cntExecuted), cntExecuted);
+    }
+}
+
+TEST_CASE("the occupy slice stays within the policy bounds")
+{
+    restriction_controller controller = make_controller();
+
+    // No backlog asks for the whole 10ms target, more than the 2ms bound.
+    for (int i = 0; i < 200; ++i)
+        controller.update(0, 0);
+    CHECK(controller.getRestriction().MAX_OCCUPY_TICK == 2ms);
+    CHECK(controller.getRestriction().MAX_OCCUPY_TICK_FLUSHING == 2ms);
+
+    // A huge backlog asks for almost nothing, less than the 100us bound.
+    for (int i = 0; i < 200; ++i)
+        controller.update(0, 1'000'000);
+    CHECK(controller.getRestriction().MAX_OCCUPY_TICK == 100us);
+    CHECK(controller.getRestriction().MAX_OCCUPY_TICK_FLUSHING == 100us);
+}
+
+TEST_CASE("smoothing reaches the target exactly instead of stalling short of it")
+{
+    restriction_controller controller = make_controller();
+
+    // 10ms over 10 + 1 workers' backlog is 909090ns, which no power of two
+    // divides evenly from the 1ms start.
+    const steady_tick tickTarget = steady_tick{ 10ms } / 11;
+    for (int i = 0; i < 500; ++i)
+        controller.update(0, 10);
+
+    CHECK(controller.getRestriction().MAX_OCCUPY_TICK == tickTarget);
+}
+
+TEST_CASE("the flush counts follow the measured task cost")
+{
+    restriction_controller controller = make_controller();
+
+    // 10us tasks under a converged 2ms slice afford 200 tasks per flush.
+    for (int i = 0; i < 500; ++i)
+    {
+        record(controller, 10us, 50);
+        controller.update(1000, 0);
+    }
+    CHECK(controller.getRestriction().MAX_FLUSH_COUNT == 200);
+    CHECK(controller.getRestriction().MAX_FLUSH_COUNT_AT_ONCE == MAX_FLUSH_COUNT_AT_ONCE);
+
+    // A short queue limits a single flush to what is queued...
+    controller.update(5, 0);
+    CHECK(controller.getRestriction().MAX_FLUSH_COUNT_AT_ONCE == 5);
+
+    // ...but never below the policy's floor.
+    controller.update(0, 0);
+    CHECK(controller.getRestriction().MAX_FLUSH_COUNT_AT_ONCE == MIN_FLUSH_COUNT_AT_ONCE);
+
+    // Tasks costlier than the whole slice still get the minimum count.
+    for (int i = 0; i < 500; ++i)
+    {
+        record(controller, 5ms, 1);
+        controller.update(1000, 0);
+    }
+    CHECK(controller.getRestriction().MAX_FLUSH_COUNT == MIN_FLUSH_COUNT);
+    CHECK(controller.getRestriction().MAX_FLUSH_COUNT_AT_ONCE == MIN_FLUSH_COUNT);
+}
@@ -0,0 +1,105 @@
+#include "doctest/doctest.h"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "test_environment.h"
+
+using namespace mtbase;
+using namespace mtbase::tests;
+
+TEST_CASE("a full submit batch commits without waiting for the worker")
+{
+    // MAX_SUBMIT_BATCH_SIZE in object_scheduler.
+    static constexpr int BATCH_SIZE = 64;
+
+    test_environment& env = test_environment::get();
+    auto& obj = env.makeObject<1024>();
+
+    std::atomic_int ran{ 0 };
+    std::atomic_int ranBeforeFull{ -1 };
+    std::atomic_bool isFullCommitted{ false };
+    std::atomic_bool isDone{ false };
+
+    // A worker commits its own submits only between tasks, so while this
+    // task runs nothing but a full batch can reach the object.
+    env.flusher->injectFuncTask([&]()
+        {
+            for (int i = 0; i < BATCH_SIZE - 1; ++i)
+                obj.submitFunc([&ran]() { ++ran; });
+
+            std::this_thread::sleep_for(10ms);
+            ranBeforeFull = ran.load();
+
+            obj.submitFunc([&ran]() { ++ran; });
+            isFullCommitted = wait_until([&ran]() { return ran == BATCH_SIZE; });
+            isDone = true;
+        });
+
+    REQUIRE(wait_until([&isDone]() { return isDone.load(); }));
+    CHECK(ranBeforeFull == 0);
+    CHECK(isFullCommitted);
+}
+
+TEST_CASE("submits from outside the pool commit once their deadline passes")
+{
+    constexpr int TASK_COUNT = 5;
+
+    test_environment& env = test_environment::get();
+    auto& obj = env.makeObject<1024>();
+
+    std::vector<int> seen;
+    std::atomic_int ran{ 0 };
+
+    // No flush_submits(): a worker has to pick the batch up on its deadline.
+    for (int i = 0; i < TASK_COUNT; ++i)
+    {
+        obj.submitFunc([&seen, &ran, i]()
+            {
+                seen.push_back(i);
+                ++ran;
+            });
+    }
+
+    REQUIRE(wait_until([&ran]() { return ran == TASK_COUNT; }));
+
+    for (int i = 0; i < TASK_COUNT; ++i)
+        CHECK(seen[i] == i);
+}
+
+TEST_CASE("submits to more objects than a thread buffers keep each object's order")
+{
+    constexpr int OBJECT_COUNT = 12;
+    constexpr int TASK_COUNT = 500;
+
+    test_environment& env = test_environment::get();
+
+    std::vector<schedulable_object<1024>*> objs;
+    std::vector<std::vector<int>> seen(OBJECT_COUNT);
+    for (int i = 0; i < OBJECT_COUNT; ++i)
+        objs.push_back(&env.makeObject<1024>());
+
+    std::atomic_int ran{ 0 };
+
+    for (int i = 0; i < TASK_COUNT; ++i)
+    {
+        for (int k = 0; k < OBJECT_COUNT; ++k)
+        {
+            objs[k]->submitFunc([&seen, &ran, i, k]()
+                {
+                    seen[k].push_back(i);
+                    ++ran;
+                });
+        }
+    }
+    flush_submits();
+
+    REQUIRE(wait_until([&ran]() { return ran == OBJECT_COUNT * TASK_COUNT; }));
+
+    for (int k = 0; k < OBJECT_COUNT; ++k)
+    {
+        for (int i = 0; i < TASK_COUNT; ++i)
+            CHECK(seen[k][i] == i);
+    }
+}
@@ -0,0 +1,159 @@
+#include "doctest/doctest.h"
+
+#include <atomic>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "test_environment.h"
+
+using namespace mtbase;
+using namespace mtbase::tests;
+
+TEST_CASE("a task group waits for every spawned task and rethrows a failure")
+{
+    constexpr int TASK_COUNT = 100;
+
+    test_environment& env = test_environment::get();
+
+    std::atomic_int ran{ 0 };
+    std::atomic_bool isDone{ false };
+    std::atomic_int cntRanAtWait{ -1 };
+    std::atomic_bool isRethrown{ false };
+
+    env.flusher->injectFuncTask([&]()
+        {
+            task_group group{ env.resource, *env.flusher };
+            for (int i = 0; i < TASK_COUNT; ++i)
+                group.spawn([&ran]() { ++ran; });
+            group.wait();
+            cntRanAtWait = ran.load();
+
+            group.spawn([]() { throw std::runtime_error{ "failed" }; });
+            try
+            {
+                group.wait();
+            }
+            catch (const std::runtime_error&)
+            {
+                isRethrown = true;
+            }
+
+            isDone = true;
+        });
+
+    REQUIRE(wait_until([&isDone]() { return isDone.load(); }));
+    CHECK(cntRanAtWait == TASK_COUNT);
+    CHECK(isRethrown);
+}
+
+TEST_CASE("a waiting worker helps with its own newest task first")
+{
+    constexpr int TASK_COUNT = 64;
+
+    test_environment& env = test_environment::get();
+
+    std::mutex mtx;
+    std::vector<int> helpedByOwner;
+    std::atomic_bool isDone{ false };
+
+    env.flusher->injectFuncTask([&]()
+        {
+            const std::thread::id owner = std::this_thread::get_id();
+
+            task_group group{ env.resource, *env.flusher };
+            for (int i = 0; i < TASK_COUNT; ++i)
+            {
+                group.spawn([&mtx, &helpedByOwner, owner, i]()
+                    {
+                        if (std::this_thread::get_id() != owner)
+                            return;
+
+                        std::lock_guard lock{ mtx };
+                        helpedByOwner.push_back(i);
+                    });
+            }
+            group.wait();
+
+            isDone = true;
+        });
+
+    REQUIRE(wait_until([&isDone]() { return isDone.load(); }));
+    REQUIRE(!helpedByOwner.empty());
+
+    // Thieves take from the other end, so the owner only ever moves down.
+    for (size_t i = 1; i < helpedByOwner.size(); ++i)
+        CHECK(helpedByOwner[i] < helpedByOwner[i - 1]);
+}
+
+TEST_CASE("tasks helped while an object's task waits do not run as that object")
+{
+    constexpr int TASK_COUNT = 64;
+
+    test_environment& env = test_environment::get();
+    auto& obj = env.makeObject<1024>();
+
+    std::atomic_int cntAsObject{ 0 };
+    std::atomic_bool isRestored{ false };
+    std::atomic_bool isDone{ false };
+
+    REQUIRE(obj.scheduleFunc([&]()
+        {
+            task_group group{ env.resource, *env.flusher };
+            for (int i = 0; i < TASK_COUNT; ++i)
+            {
+                group.spawn([&cntAsObject]()
+                    {
+                        if (object_scheduler::current() != nullptr)
+                            ++cntAsObject;
+                    });
+            }
+            group.wait();
+
+            isRestored = object_scheduler::current() == obj.getScheduler();
+            isDone = true;
+        }));
+
+    REQUIRE(wait_until([&isDone]() { return isDone.load(); }));
+    CHECK(cntAsObject == 0);
+    CHECK(isRestored);
+}
+
+TEST_CASE("parallel_for visits every index once for any range and grain")
+{
+    test_environment& env = test_environment::get();
+
+    struct range_case
+    {
+        int count;
+        int grain;
+    };
+
+    static constexpr range_case CASES[] = {
+        { 0, 1 }, { 1, 1 }, { 7, 8 }, { 8, 8 }, { 9, 8 }, { 1000, 1 }, { 10000, 64 } };
+
+    for (const range_case& rc : CASES)
+    {
+        std::vector<std::atomic_int> visits(rc.count);
+        std::atomic_bool isDone{ false };
+
+        env.flusher->injectFuncTask([&]()
+            {
+                task_group group{ env.resource, *env.flusher };
+                parallel_for(group, 0, rc.count, rc.grain, [&visits](const int i)
+                    {
+                        ++visits[i];
+                    });
+
+                isDone = true;
+            });
+
+        REQUIRE(wait_until([&isDone]() { return isDone.load(); }));
+
+        int cntWrong = 0;
+        for (const std::atomic_int& visit : visits)
+            cntWrong += visit != 1 ? 1 : 0;
+        CHECK(cntWrong == 0);
+    }
+}
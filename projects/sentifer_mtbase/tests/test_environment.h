@@ -0,0 +1,173 @@
+#pragma once
+
+#include <chrono>
+#include <memory_resource>
+#include <thread>
+#include <vector>
+
+#include "sentifer_mtbase/mtbase.h"
+#include "sentifer_mtbase/details/control_block.h"
+
+namespace mtbase::tests
+{
+    using namespace std::chrono_literals;
+
+    struct test_worker final :
+        public thread_local_scheduler
+    {
+        test_worker(
+            std::pmr::memory_resource* const res,
+            object_flush_scheduler& objectFlushSched,
+            const size_t workerIndex,
+            const idle_policy& idlePolicy = idle_policy{ 64, 16, 10ms }) :
+            thread_local_scheduler{
+                res, objectFlushSched,
+                new task_wait_free_deque<1024>{ res },
+                new task_wait_free_deque<1024>{ res },
+                workerIndex, idle_policy{ idlePolicy }, 1ms },
+            flusherBlock{ *this },
+            objectBlock{ *this },
+            flusher{ objectFlushSched }
+        {}
+
+    public:
+        control_block& getControlBlock(const scheduler* const sched)
+            noexcept override
+        {
+            return sched == &flusher ? flusherBlock : objectBlock;
+        }
+
+    private:
+        control_block flusherBlock;
+        control_block objectBlock;
+        object_flush_scheduler& flusher;
+    };
+
+    // Workers only return from flush() once their flusher is stopped, which
+    // this shared environment never is: it is built once per test binary
+    // and intentionally never torn down.
+    struct test_environment final
+    {
+        static constexpr size_t WORKER_COUNT = 4;
+        static constexpr size_t DEADLINE_BUCKET_COUNT = 4;
+
+        test_environment() :
+            resource{ new std::pmr::synchronized_pool_resource{} }
+        {
+            std::vector<task_storage*> shardStorages;
+            std::vector<task_storage*> deadlineStorages;
+
+            for (size_t i = 0; i < WORKER_COUNT; ++i)
+                shardStorages.push_back(new task_wait_free_deque<1024>{ resource });
+            for (size_t i = 0; i < DEADLINE_BUCKET_COUNT; ++i)
+                deadlineStorages.push_back(new task_wait_free_deque<1024>{ resource });
+
+            flusher = new object_flush_scheduler{
+                resource, new task_wait_free_deque<1024>{ resource },
+                shardStorages, deadlineStorages,
+                scheduler_restriction{ 1ms, 1ms, 100, 10 }, 8, 1ms };
+
+            for (size_t i = 0; i < WORKER_COUNT; ++i)
+            {
+                test_worker* const worker = new test_worker{ resource, *flusher, i };
+                std::thread{ [worker]() { worker->flush(); } }.detach();
+            }
+        }
+
+    public:
+        [[nodiscard]]
+        static test_environment& get()
+        {
+            static test_environment* const env = new test_environment{};
+            return *env;
+        }
+
+        // A worker may still be finishing an object's flush after its last
+        // task ran, so test objects and the transaction schedulers locking them
+        // share the environment's lifetime.
+        template<size_t Capacity>
+        [[nodiscard]]
+        schedulable_object<Capacity>& makeObject()
+        {
+            return *new schedulable_object<Capacity>{
+                resource, *flusher, scheduler_restriction{ 1ms, 1ms, 100, 10 } };
+        }
+
+        [[nodiscard]]
+        transaction_scheduler& makeTransactionScheduler()
+        {
+            return *new transaction_scheduler{ resource };
+        }
+
+    public:
+        std::pmr::memory_resource* const resource;
+        object_flush_scheduler* flusher{ nullptr };
+    };
+
+    // A throwing task unwinds its worker, which the shared environment can
+    // not afford. This pool counts how many of its workers were unwound.
+    struct throwing_pool final
+    {
+        static constexpr size_t WORKER_COUNT = 2;
+
+        throwing_pool() :
+            resource{ new std::pmr::synchronized_pool_resource{} }
+        {
+            std::vector<task_storage*> shardStorages;
+            for (size_t i = 0; i < WORKER_COUNT; ++i)
+                shardStorages.push_back(new task_wait_free_deque<1024>{ resource });
+
+            flusher = new object_flush_scheduler{
+                resource, new task_wait_free_deque<1024>{ resource },
+                shardStorages, std::span<task_storage* const>{},
+                scheduler_restriction{ 1ms, 1ms, 100, 10 }, 8, 1ms };
+
+            for (size_t i = 0; i < WORKER_COUNT; ++i)
+            {
+                test_worker* const worker = new test_worker{ resource, *flusher, i };
+                std::thread{ [this, worker]()
+                    {
+                        try
+                        {
+                            worker->flush();
+                        }
+                        catch (...)
+                        {
+                            ++cntUnwound;
+                        }
+                    } }.detach();
+            }
+        }
+
+    public:
+        template<size_t Capacity>
+        [[nodiscard]]
+        schedulable_object<Capacity>& makeObject()
+        {
+            return *new schedulable_object<Capacity>{
+                resource, *flusher, scheduler_restriction{ 1ms, 1ms, 100, 10 } };
+        }
+
+    public:
+        std::pmr::memory_resource* const resource;
+        object_flush_scheduler* flusher{ nullptr };
+        std::atomic_int cntUnwound{ 0 };
+    };
+
+    template<class Pred>
+    [[nodiscard]]
+    bool wait_until(Pred&& pred, const std::chrono::milliseconds timeout = 5s)
+    {
+        const auto deadline = std::chrono::steady_clock::now() + timeout;
+
+        while (!pred())
+        {
+            if (std::chrono::steady_clock::now() >= deadline)
+                return pred();
+
+            std::this_thread::sleep_for(1ms);
+        }
+
+        return true;
+    }
+}
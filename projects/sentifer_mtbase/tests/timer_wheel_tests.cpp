@@ -0,0 +1,197 @@
+#include "doctest/doctest.h"
+
+#include <atomic>
+#include <chrono>
+#include <memory_resource>
+#include <tuple>
+#include <vector>
+
+#include "test_environment.h"
+
+using namespace mtbase;
+using namespace mtbase::tests;
+
+namespace
+{
+    struct wheel_fixture
+    {
+        [[nodiscard]]
+        task_timed_invoke_t* makeTimer(const steady_tick at)
+        {
+            task_invoke_t* const target = alloc.new_func_task([]() {}, std::make_tuple());
+
+            return alloc.new_timed_invoke_task(nullptr, target, at, steady_tick{});
+        }
+
+        // Releases every timer of an expired list and returns how many there were.
+        size_t releaseExpired(task_timed_invoke_t* expired)
+        {
+            size_t cnt = 0;
+
+            while (expired != nullptr)
+            {
+                task_timed_invoke_t* const next = expired->next;
+                expired->release();
+                expired = next;
+
+                ++cnt;
+            }
+
+            return cnt;
+        }
+
+    public:
+        std::pmr::unsynchronized_pool_resource resource;
+        task_allocator alloc{ &resource };
+        timer_wheel wheel{ 1ms, steady_tick{} };
+    };
+}
+
+TEST_CASE("a timer expires on its tick and not before")
+{
+    wheel_fixture f;
+
+    task_timed_invoke_t* const timer = f.makeTimer(5ms);
+    f.wheel.insert(timer);
+    CHECK(f.wheel.size() == 1);
+
+    CHECK(f.wheel.advance(4ms) == nullptr);
+
+    task_timed_invoke_t* const expired = f.wheel.advance(5ms);
+    CHECK(expired == timer);
+    CHECK(f.wheel.size() == 0);
+    CHECK(f.releaseExpired(expired) == 1);
+}
+
+TEST_CASE("timers sharing a tick expire together")
+{
+    wheel_fixture f;
+
+    for (int i = 0; i < 3; ++i)
+        f.wheel.insert(f.makeTimer(7ms));
+    f.wheel.insert(f.makeTimer(8ms));
+
+    CHECK(f.releaseExpired(f.wheel.advance(7ms)) == 3);
+    CHECK(f.wheel.size() == 1);
+    CHECK(f.releaseExpired(f.wheel.advance(8ms)) == 1);
+}
+
+TEST_CASE("timers on outer levels cascade down and expire on time")
+{
+    wheel_fixture f;
+
+    // One timer per level: the wheel has 64 slots per level.
+    const steady_tick expiries[] = { 40ms, 100ms, 5000ms, 300000ms };
+    for (const steady_tick at : expiries)
+        f.wheel.insert(f.makeTimer(at));
+
+    CHECK(f.wheel.size() == 4);
+
+    for (const steady_tick at : expiries)
+    {
+        CHECK(f.wheel.advance(at - 1ms) == nullptr);
+        CHECK(f.releaseExpired(f.wheel.advance(at)) == 1);
+    }
+
+    CHECK(f.wheel.size() == 0);
+}
+
+TEST_CASE("an erased timer never expires")
+{
+    wheel_fixture f;
+
+    task_timed_invoke_t* const kept = f.makeTimer(200ms);
+    task_timed_invoke_t* const erased = f.makeTimer(200ms);
+    f.wheel.insert(kept);
+    f.wheel.insert(erased);
+
+    f.wheel.erase(erased);
+    CHECK(f.wheel.size() == 1);
+    CHECK(erased->wheel.load() == nullptr);
+    erased->release();
+
+    task_timed_invoke_t* const expired = f.wheel.advance(200ms);
+    CHECK(expired == kept);
+    CHECK(expired->next == nullptr);
+    CHECK(f.releaseExpired(expired) == 1);
+}
+
+TEST_CASE("the next expiry never overshoots the earliest timer")
+{
+    wheel_fixture f;
+
+    CHECK(f.wheel.getNextExpiry(50ms) == 50ms);
+
+    f.wheel.insert(f.makeTimer(10ms));
+    CHECK(f.wheel.getNextExpiry(50ms) == 10ms);
+    CHECK(f.wheel.getNextExpiry(3ms) == 3ms);
+
+    CHECK(f.releaseExpired(f.wheel.advance(10ms)) == 1);
+
+    // A far timer sits on an outer level, so the wheel may wake up early to
+    // cascade it, but never after it is due.
+    f.wheel.insert(f.makeTimer(1000ms));
+    const steady_tick next = f.wheel.getNextExpiry(5000ms);
+    CHECK(next > 10ms);
+    CHECK(next <= 1000ms);
+}
+
+TEST_CASE("object timers fire once when due and never after being cancelled")
+{
+    constexpr int TIMER_COUNT = 200;
+
+    test_environment& env = test_environment::get();
+    auto& obj = env.makeObject<1024>();
+
+    std::atomic_int fired{ 0 };
+    std::atomic_int early{ 0 };
+    std::atomic_int cancelledFired{ 0 };
+
+    std::vector<timer_handle> handles;
+    for (int i = 0; i < TIMER_COUNT; ++i)
+    {
+        const steady_tick at = mtbase::clock_t::getSteadyTick() + steady_tick{ 1ms } * (i % 50);
+        const bool isCancelled = (i % 2 == 1);
+
+        handles.push_back(obj.scheduleFuncAt(at, [&, at, isCancelled]()
+            {
+                if (mtbase::clock_t::getSteadyTick() < at)
+                    ++early;
+                if (isCancelled)
+                    ++cancelledFired;
+
+                ++fired;
+            }));
+    }
+
+    for (int i = 1; i < TIMER_COUNT; i += 2)
+        CHECK(handles[i].cancel());
+
+    REQUIRE(wait_until([&fired]() { return fired == TIMER_COUNT / 2; }));
+
+    // Leave the cancelled timers time to come due before checking they stayed quiet.
+    std::this_thread::sleep_for(100ms);
+
+    CHECK(fired == TIMER_COUNT / 2);
+    CHECK(cancelledFired == 0);
+    CHECK(early == 0);
+}
+
+TEST_CASE("a periodic timer keeps firing until it is cancelled")
+{
+    test_environment& env = test_environment::get();
+    auto& obj = env.makeObject<1024>();
+
+    std::atomic_int fired{ 0 };
+    timer_handle handle = obj.scheduleFuncEvery(2ms, [&fired]() { ++fired; });
+
+    REQUIRE(wait_until([&fired]() { return fired >= 5; }));
+    CHECK(handle.cancel());
+
+    // A tick already handed to the object may still run once.
+    std::this_thread::sleep_for(20ms);
+    const int firedAtCancel = fired;
+    std::this_thread::sleep_for(50ms);
+
+    CHECK(fired == firedAtCancel);
+}
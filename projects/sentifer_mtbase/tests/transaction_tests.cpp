@@ -0,0 +1,175 @@
+#include "doctest/doctest.h"
+
+#include <algorithm>
+#include <atomic>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "test_environment.h"
+
+using namespace mtbase;
+using namespace mtbase::tests;
+
+namespace
+{
+    struct account
+    {
+        int balance{ 1000 };
+        std::atomic_int cntInside{ 0 };
+    };
+}
+
+TEST_CASE("a transaction waits for every object it spans")
+{
+    test_environment& env = test_environment::get();
+    auto& a = env.makeObject<1024>();
+    auto& b = env.makeObject<1024>();
+    auto& transactions = env.makeTransactionScheduler();
+
+    std::atomic_bool gate{ false };
+    std::atomic_bool isGateRunning{ false };
+    std::atomic_int committed{ 0 };
+
+    REQUIRE(a.scheduleFunc([&]()
+        {
+            isGateRunning = true;
+            while (!gate)
+                std::this_thread::yield();
+        }));
+    REQUIRE(wait_until([&isGateRunning]() { return isGateRunning.load(); }));
+
+    object_scheduler* const scheds[] = { a.getScheduler(), b.getScheduler() };
+    transactions.registerTransaction(scheds, [&committed]() { ++committed; });
+
+    std::this_thread::sleep_for(20ms);
+    CHECK(committed == 0);
+
+    gate = true;
+    CHECK(wait_until([&committed]() { return committed == 1; }));
+}
+
+TEST_CASE("an object listed twice in a transaction is locked once")
+{
+    test_environment& env = test_environment::get();
+    auto& a = env.makeObject<1024>();
+    auto& transactions = env.makeTransactionScheduler();
+
+    std::atomic_int committed{ 0 };
+
+    object_scheduler* const scheds[] = { a.getScheduler(), a.getScheduler() };
+    transactions.registerTransaction(scheds, [&committed]() { ++committed; });
+
+    REQUIRE(wait_until([&committed]() { return committed == 1; }));
+    REQUIRE(a.scheduleFunc([&committed]() { ++committed; }));
+    CHECK(wait_until([&committed]() { return committed == 2; }));
+}
+
+TEST_CASE("a transaction whose body throws hands the other objects back")
+{
+    constexpr int OBJECT_COUNT = 3;
+
+    throwing_pool& pool = *new throwing_pool{};
+    auto& transactions = *new transaction_scheduler{ pool.resource };
+
+    std::vector<schedulable_object<1024>*> objs;
+    std::vector<object_scheduler*> scheds;
+    for (int i = 0; i < OBJECT_COUNT; ++i)
+    {
+        objs.push_back(&pool.makeObject<1024>());
+        scheds.push_back(objs.back()->getScheduler());
+    }
+
+    transactions.registerTransaction(
+        std::span<object_scheduler* const>{ scheds },
+        []() { throw std::runtime_error{ "failed" }; });
+
+    REQUIRE(wait_until([&pool]() { return pool.cntUnwound == 1; }));
+
+    // Objects are acquired in address order, so the last one ran the body
+    // and was unwound with its worker.
+    object_scheduler* const bodySched = *std::max_element(scheds.begin(), scheds.end());
+
+    std::atomic_int ran{ 0 };
+    for (auto* const obj : objs)
+    {
+        if (obj->getScheduler() != bodySched)
+            REQUIRE(obj->scheduleFunc([&ran]() { ++ran; }));
+    }
+
+    CHECK(wait_until([&ran]() { return ran == OBJECT_COUNT - 1; }));
+}
+
+TEST_CASE("transfers between objects keep the total and exclude the objects' own tasks")
+{
+    constexpr int ACCOUNT_COUNT = 4;
+    constexpr int PRODUCER_COUNT = 4;
+    constexpr int TRANSFER_COUNT = 500;
+
+    test_environment& env = test_environment::get();
+    auto& transactions = env.makeTransactionScheduler();
+
+    std::vector<schedulable_object<4096>*> objs;
+    for (int i = 0; i < ACCOUNT_COUNT; ++i)
+        objs.push_back(&env.makeObject<4096>());
+
+    account accounts[ACCOUNT_COUNT];
+    std::atomic_int violations{ 0 };
+    std::atomic_int ran{ 0 };
+
+    auto enter = [&](const int i)
+    {
+        if (accounts[i].cntInside.fetch_add(1) != 0)
+            ++violations;
+    };
+    auto leave = [&](const int i)
+    {
+        accounts[i].cntInside.fetch_sub(1);
+    };
+
+    std::vector<std::thread> producers;
+    for (int p = 0; p < PRODUCER_COUNT; ++p)
+    {
+        producers.emplace_back([&, p]()
+            {
+                for (int n = 0; n < TRANSFER_COUNT; ++n)
+                {
+                    const int from = (p + n) % ACCOUNT_COUNT;
+                    const int to = (from + 1 + n % (ACCOUNT_COUNT - 1)) % ACCOUNT_COUNT;
+
+                    object_scheduler* const scheds[] = {
+                        objs[from]->getScheduler(), objs[to]->getScheduler() };
+                    transactions.registerTransaction(scheds, [&, from, to]()
+                        {
+                            enter(from);
+                            enter(to);
+                            --accounts[from].balance;
+                            ++accounts[to].balance;
+                            leave(from);
+                            leave(to);
+                            ++ran;
+                        });
+
+                    while (!objs[from]->scheduleFunc([&, from]()
+                        {
+                            enter(from);
+                            leave(from);
+                            ++ran;
+                        }))
+                        std::this_thread::yield();
+                }
+            });
+    }
+
+    for (auto& producer : producers)
+        producer.join();
+
+    REQUIRE(wait_until([&ran]() { return ran == PRODUCER_COUNT * TRANSFER_COUNT * 2; }, 10s));
+
+    int sum = 0;
+    for (const account& acc : accounts)
+        sum += acc.balance;
+
+    CHECK(sum == 1000 * ACCOUNT_COUNT);
+    CHECK(violations == 0);
+}
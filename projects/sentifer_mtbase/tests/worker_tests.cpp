@@ -0,0 +1,91 @@
+#include "doctest/doctest.h"
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+#include "test_environment.h"
+
+using namespace mtbase;
+using namespace mtbase::tests;
+
+namespace
+{
+    // A single worker of its own, so the test can watch it go idle and stop
+    // it without disturbing the shared environment.
+    struct single_worker_pool final
+    {
+        explicit single_worker_pool(const idle_policy& idlePolicy) :
+            resource{ new std::pmr::synchronized_pool_resource{} }
+        {
+            task_storage* const shardStorages[] = { new task_wait_free_deque<1024>{ resource } };
+
+            flusher = new object_flush_scheduler{
+                resource, new task_wait_free_deque<1024>{ resource },
+                shardStorages, std::span<task_storage* const>{},
+                scheduler_restriction{ 1ms, 1ms, 100, 10 }, 8, 1ms };
+            worker = new test_worker{ resource, *flusher, 0, idlePolicy };
+        }
+
+    public:
+        void start()
+        {
+            thread = std::thread{ [this]() { worker->flush(); } };
+        }
+
+        void stop()
+        {
+            flusher->requestStop();
+            thread.join();
+
+            delete worker;
+            delete flusher;
+        }
+
+    public:
+        std::pmr::memory_resource* const resource;
+        object_flush_scheduler* flusher{ nullptr };
+        test_worker* worker{ nullptr };
+        std::thread thread;
+    };
+}
+
+TEST_CASE("an idle worker spins, parks, and an injected task wakes it")
+{
+    // Parks long enough that only a notification can end the wait in time.
+    single_worker_pool pool{ idle_policy{ 64, 16, 1h } };
+    pool.start();
+
+    REQUIRE(wait_until([&pool]() { return pool.flusher->getIdleStatistics().cntParked >= 1; }));
+
+    std::atomic_bool isRan{ false };
+    pool.flusher->injectFuncTask([&isRan]() { isRan = true; });
+
+    CHECK(wait_until([&isRan]() { return isRan.load(); }));
+    CHECK(pool.flusher->getIdleStatistics().cntWokenUp >= 1);
+
+    // Back to idle: spinning and yielding again before the next park.
+    REQUIRE(wait_until([&pool]() { return pool.flusher->getIdleStatistics().cntParked >= 2; }));
+
+    const auto stopBegin = std::chrono::steady_clock::now();
+    pool.stop();
+    CHECK(std::chrono::steady_clock::now() - stopBegin < 5s);
+}
+
+TEST_CASE("a stopped worker finishes queued tasks before flush returns")
+{
+    constexpr int TASK_COUNT = 100;
+
+    single_worker_pool pool{ idle_policy{ 64, 16, 10ms } };
+
+    std::atomic_int ran{ 0 };
+    for (int i = 0; i < TASK_COUNT; ++i)
+        pool.flusher->injectFuncTask([&ran]() { ++ran; });
+
+    // Stopped before it ever ran, so flush() sees the flag with work queued.
+    pool.flusher->requestStop();
+    pool.start();
+    pool.stop();
+
+    CHECK(ran == TASK_COUNT);
+}
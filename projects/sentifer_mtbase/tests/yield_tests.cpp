@@ -0,0 +1,69 @@
+#include "doctest/doctest.h"
+
+#include <atomic>
+#include <chrono>
+
+#include "test_environment.h"
+
+using namespace mtbase;
+using namespace mtbase::tests;
+
+TEST_CASE("should_yield is false outside an object's task")
+{
+    test_environment& env = test_environment::get();
+
+    CHECK(!should_yield());
+
+    std::atomic_int onWorker{ -1 };
+    env.flusher->injectFuncTask([&onWorker]() { onWorker = should_yield() ? 1 : 0; });
+
+    REQUIRE(wait_until([&onWorker]() { return onWorker >= 0; }));
+    CHECK(onWorker == 0);
+}
+
+TEST_CASE("should_yield turns true once a long task spends the object's budget")
+{
+    test_environment& env = test_environment::get();
+    auto& obj = env.makeObject<1024>();
+
+    std::atomic_bool isYielding{ false };
+    std::atomic<std::chrono::steady_clock::duration> elapsed{};
+    std::atomic_bool isDone{ false };
+
+    REQUIRE(obj.scheduleFunc([&]()
+        {
+            const auto begin = std::chrono::steady_clock::now();
+            const auto giveUp = begin + 1s;
+
+            while (!should_yield() && std::chrono::steady_clock::now() < giveUp)
+                ;
+
+            isYielding = should_yield();
+            elapsed = std::chrono::steady_clock::now() - begin;
+            isDone = true;
+        }));
+
+    REQUIRE(wait_until([&isDone]() { return isDone.load(); }));
+    CHECK(isYielding);
+
+    // A 1ms budget, checked every YIELD_CHECK_CYCLE_COUNT cycles.
+    CHECK(elapsed.load() < 100ms);
+}
+
+TEST_CASE("should_yield is true as soon as the task queued its continuation")
+{
+    test_environment& env = test_environment::get();
+    auto& obj = env.makeObject<1024>();
+
+    std::atomic_int afterYield{ -1 };
+    std::atomic_bool isContinued{ false };
+
+    REQUIRE(obj.scheduleFunc([&]()
+        {
+            yield_with([&isContinued]() { isContinued = true; });
+            afterYield = should_yield() ? 1 : 0;
+        }));
+
+    REQUIRE(wait_until([&isContinued]() { return isContinued.load(); }));
+    CHECK(afterYield == 1);
+}